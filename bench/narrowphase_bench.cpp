@@ -0,0 +1,150 @@
+// Measures the per-pair cost of the narrowphase: the type-indexed table against the virtual
+// call + dynamic_cast chain that collidesWith used before, which the old loop ran in both orders.
+
+#include "common.h"
+#include "types.h"
+#include "world.h"
+#include "narrowphase.h"
+#include "broadphase.h"
+#include <array>
+#include <chrono>
+#include <random>
+#include <string>
+
+namespace
+{
+
+using namespace kq;
+
+// The old chain reached a fixed overload once the casts had found the other type. Resolving every
+// test up front keeps that shape: the dynamic_cast chain picks which of them runs, and both
+// sides run the same shape tests, so only the dispatch differs.
+using legacyRow = std::array<narrowphase::testFunction, narrowphase::typeCount>;
+std::array<legacyRow, narrowphase::typeCount> legacyTests;
+
+void resolveLegacyTests()
+{
+    for(size_t a = 0; a < narrowphase::typeCount; ++a)
+    {
+        for(size_t b = 0; b < narrowphase::typeCount; ++b)
+        {
+            legacyTests[a][b] = narrowphase::getTest(static_cast<objectType>(a), static_cast<objectType>(b));
+        }
+    }
+}
+
+template<typename Shape>
+bool legacyDispatch(const Shape& shape, const legacyRow& tests, const physicalObject& other)
+{
+    contact result;
+    if (const Circle* circle = dynamic_cast<const Circle*>(&other))
+        return tests[static_cast<size_t>(objectType::Circle)](shape, *circle, result, nullptr);
+    else if (const Square* square = dynamic_cast<const Square*>(&other))
+        return tests[static_cast<size_t>(objectType::Square)](shape, *square, result, nullptr);
+    else if(const Triangle* triangle = dynamic_cast<const Triangle*>(&other))
+        return tests[static_cast<size_t>(objectType::Triangle)](shape, *triangle, result, nullptr);
+    else if(const Rectangle* rectangle = dynamic_cast<const Rectangle*>(&other))
+        return tests[static_cast<size_t>(objectType::Rectangle)](shape, *rectangle, result, nullptr);
+    return false;
+}
+
+// The old override was reached through the vtable; getType() stands in for that call.
+bool legacyCollide(const physicalObject& a, const physicalObject& b)
+{
+    switch(a.getType())
+    {
+        case objectType::Circle:
+            return legacyDispatch(static_cast<const Circle&>(a), legacyTests[static_cast<size_t>(objectType::Circle)], b);
+        case objectType::Square:
+            return legacyDispatch(static_cast<const Square&>(a), legacyTests[static_cast<size_t>(objectType::Square)], b);
+        case objectType::Triangle:
+            return legacyDispatch(static_cast<const Triangle&>(a), legacyTests[static_cast<size_t>(objectType::Triangle)], b);
+        case objectType::Rectangle:
+            return legacyDispatch(static_cast<const Rectangle&>(a), legacyTests[static_cast<size_t>(objectType::Rectangle)], b);
+        default: return false;
+    }
+}
+
+bool legacyPair(const physicalObject& a, const physicalObject& b)
+{
+    return legacyCollide(a, b) | legacyCollide(b, a);
+}
+
+bool tablePair(const physicalObject& a, const physicalObject& b)
+{
+    contact result;
+    return narrowphase::collide(a, b, result);
+}
+
+template<typename Test>
+double timePairs(const std::vector<physicalObject*>& entities, const std::vector<collisionPair>& pairs,
+                 Test&& test, uint32_t repetitions, uint64_t& hits)
+{
+    double best = 1e300;
+    for(uint32_t r = 0; r < repetitions; ++r)
+    {
+        uint64_t count = 0;
+        auto start = std::chrono::steady_clock::now();
+        for(const collisionPair& pair : pairs)
+        {
+            count += test(*entities[pair.first], *entities[pair.second]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+        hits = count;
+    }
+    return best / pairs.size();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t bodyCount = argc > 1 ? std::stoul(argv[1]) : 2000;
+    uint32_t pairCount = argc > 2 ? std::stoul(argv[2]) : 1 << 20;
+    uint32_t repetitions = 5;
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> x(0.f, SCREEN_WIDTH_F);
+    std::uniform_real_distribution<float> y(0.f, SCREEN_LENGTH_F);
+    std::uniform_real_distribution<float> size(50.f, 150.f);
+    std::uniform_int_distribution<int> type(0, 3);
+
+    world scene;
+    std::vector<physicalObject*> entities;
+    for(uint32_t i = 0; i < bodyCount; ++i)
+    {
+        physicalObjectArgs args({x(random), y(random)}, {}, rgba(), 1.f, static_cast<objectType>(type(random)));
+        switch(args.type)
+        {
+            case objectType::Circle: entities.push_back(new Circle(scene, std::move(args), size(random) / 2)); break;
+            case objectType::Square: entities.push_back(new Square(scene, std::move(args), size(random))); break;
+            case objectType::Rectangle: entities.push_back(new Rectangle(scene, std::move(args), size(random), size(random))); break;
+            default: entities.push_back(new Triangle(scene, std::move(args), size(random))); break;
+        }
+    }
+
+    std::uniform_int_distribution<uint32_t> body(0, bodyCount - 1);
+    std::vector<collisionPair> pairs(pairCount);
+    for(collisionPair& pair : pairs)
+    {
+        pair = {body(random), body(random)};
+    }
+
+    resolveLegacyTests();
+    uint64_t legacyHits = 0;
+    uint64_t tableHits = 0;
+    double legacy = timePairs(entities, pairs, legacyPair, repetitions, legacyHits);
+    double table = timePairs(entities, pairs, tablePair, repetitions, tableHits);
+
+    std::cout << "bodies: " << bodyCount << ", pairs: " << pairCount << "\n";
+    std::cout << "dynamic_cast chain: " << legacy << " ns/pair (" << legacyHits << " hits)\n";
+    std::cout << "dispatch table:     " << table << " ns/pair (" << tableHits << " hits)\n";
+    std::cout << "speedup: " << legacy / table << "x\n";
+
+    for(physicalObject* entity : entities)
+    {
+        delete entity;
+    }
+    return legacyHits == tableHits ? 0 : 1;
+}
@@ -0,0 +1,348 @@
+// Times each part of a simulation step, the renderer's batch fill and the CSV and snapshot I/O on
+// seeded scenes from 100 up to 1M bodies. Every phase is timed separately per step and reported
+// with its median, p95 and p99 so regressions show up in the tail as well as on average.
+//
+// usage: physim_bench [--bodies 100,1000,...] [--mixes circles,mixed,boxes,convex] [--steps N] [--seed N]
+//                     [--threads N] [--io-repeats N] [--format json|csv] [--out file]
+
+#include "common.h"
+#include "simulation.h"
+#include "drawBatch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+using namespace kq;
+
+struct shapeMix
+{
+    const char* name;
+    // Relative weights of circles, squares, rectangles, triangles and convex polygons.
+    float weights[5];
+};
+
+const shapeMix mixes[] = {
+    {"circles", {1.f, 0.f, 0.f, 0.f, 0.f}},
+    {"mixed", {1.f, 1.f, 1.f, 1.f, 0.f}},
+    {"boxes", {0.f, 1.f, 1.f, 0.f, 0.f}},
+    {"convex", {1.f, 1.f, 0.f, 1.f, 2.f}},
+};
+
+struct options
+{
+    std::vector<uint32_t> bodies = {100, 1000, 10000, 100000, 1000000};
+    std::vector<std::string> mixes = {"circles", "mixed"};
+    uint32_t steps = 200;
+    uint32_t seed = 42;
+    uint32_t threads = 0;
+    uint32_t ioRepeats = 3;
+    std::string format = "json";
+    std::string out;
+};
+
+struct result
+{
+    uint32_t bodies;
+    std::string mix;
+    std::string phase;
+    std::vector<double> samples;
+};
+
+// Large scenes run fewer steps so the whole suite stays in the minutes range.
+uint32_t stepsFor(const options& options, uint32_t bodies)
+{
+    return std::max(10u, std::min(options.steps, static_cast<uint32_t>(20000000ull / bodies)));
+}
+
+// Bodies are sized so every scene covers about the same fraction of the screen.
+float baseRadius(uint32_t bodies)
+{
+    float radius = std::sqrt(SCREEN_WIDTH_F * SCREEN_LENGTH_F * 0.25f / (bodies * pi));
+    return std::clamp(radius, 0.5f, 40.f);
+}
+
+void buildScene(simulation& simulation, const shapeMix& mix, uint32_t bodies, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    float radius = baseRadius(bodies);
+    std::uniform_real_distribution<float> size(0.5f * radius, 1.5f * radius);
+    std::uniform_real_distribution<float> x(2 * radius, SCREEN_WIDTH_F - 2 * radius);
+    std::uniform_real_distribution<float> y(2 * radius, SCREEN_LENGTH_F - 2 * radius);
+    std::uniform_real_distribution<float> speed(-100.f, 100.f);
+    std::uniform_int_distribution<int> channel(0, 255);
+    std::discrete_distribution<int> type(std::begin(mix.weights), std::end(mix.weights));
+    std::uniform_int_distribution<uint32_t> sides(5, polygon::maxVertices);
+    std::uniform_real_distribution<float> angle(0.f, 2 * pi);
+
+    simulation.getCollider().setCellSize(4 * radius);
+    for(uint32_t i = 0; i < bodies; ++i)
+    {
+        objectType shape = static_cast<objectType>(type(random));
+        float extent = size(random);
+        vector2f box = {2 * extent, 2 * size(random)};
+        rgba color(channel(random), channel(random), channel(random));
+        if(shape == objectType::Convex)
+        {
+            // Five sides or more, so pairs of them go through GJK rather than SAT.
+            polygon outline = polygon::regular(sides(random), extent, angle(random));
+            simulation.createObject({x(random), y(random)}, {speed(random), speed(random)}, color, 1.f, outline);
+            continue;
+        }
+        // Squares and triangles take their side length through the radius argument.
+        float side = shape == objectType::Circle ? extent : 2 * extent;
+        simulation.createObject(shape, {x(random), y(random)}, {speed(random), speed(random)}, color, 1.f, side, box);
+    }
+}
+
+double timeMs(const std::function<void()>& function)
+{
+    auto start = std::chrono::steady_clock::now();
+    function();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void runScene(const options& options, const shapeMix& mix, uint32_t bodies, std::vector<result>& results)
+{
+    simulation scene;
+    if(options.threads != 0)
+        scene.getThreadPool().setThreadCount(options.threads);
+    buildScene(scene, mix, bodies, options.seed);
+
+    world& world = scene.getWorld();
+    threadPool& pool = scene.getThreadPool();
+    const float deltaTime = scene.getStepSize();
+    drawBatch batch;
+    // Everything in view at full detail, the worst case for the renderer.
+    AABB visible = {{0.f, 0.f}, world.getSize()};
+    std::vector<uint32_t> candidates(world.size());
+    std::iota(candidates.begin(), candidates.end(), 0u);
+
+    // Named after simulation::stepPhases, in the same order.
+    const char* phases[] = {"integrate", "geometry", "broadphase", "timeOfImpact", "narrowphase", "resolveCollision", "islands", "drawPrep", "step"};
+    constexpr size_t stepPhaseCount = simulation::stepPhases.size();
+    static_assert(std::size(phases) == stepPhaseCount + 2, "one name per step phase, then drawPrep and step");
+    std::vector<result> timings;
+    for(const char* phase : phases)
+    {
+        timings.push_back({bodies, mix.name, phase, {}});
+    }
+
+    // The phases of simulation::step, timed one by one.
+    uint32_t steps = stepsFor(options, bodies);
+    for(uint32_t step = 0; step < steps; ++step)
+    {
+        double total = 0.0;
+        for(size_t i = 0; i < stepPhaseCount; ++i)
+        {
+            double time = timeMs([&] { scene.runPhase(simulation::stepPhases[i], deltaTime); });
+            timings[i].samples.push_back(time);
+            total += time;
+        }
+        timings[stepPhaseCount].samples.push_back(timeMs([&]
+        {
+            batch.fill(world, scene.getGeometry(), candidates, 0.5f, pool, visible, 0.f);
+        }));
+        timings[stepPhaseCount + 1].samples.push_back(total);
+    }
+
+    std::string filename = "physim_bench_" + std::to_string(bodies) + ".csv";
+    std::string snapshotName = "physim_bench_" + std::to_string(bodies) + fileManager::snapshotExtension;
+    result save = {bodies, mix.name, "savecsv", {}};
+    result load = {bodies, mix.name, "loadcsv", {}};
+    result saveSnapshot = {bodies, mix.name, "saveSnapshot", {}};
+    result loadSnapshot = {bodies, mix.name, "loadSnapshot", {}};
+    for(uint32_t repeat = 0; repeat < options.ioRepeats; ++repeat)
+    {
+        save.samples.push_back(timeMs([&] { scene.getFileManager().savecsv(filename); }));
+        saveSnapshot.samples.push_back(timeMs([&] { scene.getFileManager().saveSnapshot(snapshotName); }));
+
+        simulation loaded;
+        load.samples.push_back(timeMs([&] { loaded.getFileManager().loadcsv(filename); }));
+        simulation loadedSnapshot;
+        loadSnapshot.samples.push_back(timeMs([&] { loadedSnapshot.getFileManager().loadSnapshot(snapshotName); }));
+    }
+    std::remove(filename.c_str());
+    std::remove(snapshotName.c_str());
+
+    results.insert(results.end(), timings.begin(), timings.end());
+    results.push_back(save);
+    results.push_back(load);
+    results.push_back(saveSnapshot);
+    results.push_back(loadSnapshot);
+}
+
+// Nearest-rank percentile of sorted samples.
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if(sorted.empty())
+        return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void writeResults(std::ostream& out, const options& options, std::vector<result>& results)
+{
+    bool json = options.format == "json";
+    if(json)
+    {
+        out << "{\n  \"seed\": " << options.seed << ",\n  \"threads\": " << (options.threads ? options.threads : threadPool::getHardwareThreads())
+            << ",\n  \"instructionSet\": \"" << circleKernel::getInstructionSetName(circleKernel::getInstructionSet())
+            << "\",\n  \"results\": [\n";
+    }
+    else
+    {
+        out << "bodies,mix,phase,samples,mean_ms,median_ms,p95_ms,p99_ms,min_ms,max_ms\n";
+    }
+
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        std::vector<double>& samples = results[i].samples;
+        std::sort(samples.begin(), samples.end());
+        double mean = 0.0;
+        for(double sample : samples)
+        {
+            mean += sample;
+        }
+        mean /= std::max<size_t>(samples.size(), 1);
+        // The 0th and 100th percentiles, which are 0 like the others when a phase has no samples.
+        double minimum = percentile(samples, 0.0);
+        double maximum = percentile(samples, 1.0);
+
+        if(json)
+        {
+            out << "    {\"bodies\": " << results[i].bodies << ", \"mix\": \"" << results[i].mix << "\", \"phase\": \""
+                << results[i].phase << "\", \"samples\": " << samples.size() << ", \"mean_ms\": " << mean
+                << ", \"median_ms\": " << percentile(samples, 0.5) << ", \"p95_ms\": " << percentile(samples, 0.95)
+                << ", \"p99_ms\": " << percentile(samples, 0.99) << ", \"min_ms\": " << minimum
+                << ", \"max_ms\": " << maximum << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        else
+        {
+            out << results[i].bodies << "," << results[i].mix << "," << results[i].phase << "," << samples.size() << ","
+                << mean << "," << percentile(samples, 0.5) << "," << percentile(samples, 0.95) << ","
+                << percentile(samples, 0.99) << "," << minimum << "," << maximum << "\n";
+        }
+    }
+
+    if(json)
+        out << "  ]\n}\n";
+}
+
+template<typename T, typename Parse>
+std::vector<T> parseList(const std::string& list, Parse&& parse)
+{
+    std::vector<T> values;
+    std::stringstream stream(list);
+    std::string item;
+    while(std::getline(stream, item, ','))
+    {
+        values.push_back(parse(item));
+    }
+    return values;
+}
+
+// Throws like std::stoll on text that is not a whole number in range.
+uint32_t parseCount(const std::string& text)
+{
+    size_t end = 0;
+    long long value = std::stoll(text, &end);
+    if(end != text.size() || value < 0 || value > UINT32_MAX)
+        throw std::out_of_range(text);
+    return static_cast<uint32_t>(value);
+}
+
+int usage(const char* program)
+{
+    std::cerr << "usage: " << program << " [--bodies 100,1000,...] [--mixes circles,mixed,boxes,convex] [--steps N] [--seed N]\n"
+              << "       [--threads N] [--io-repeats N] [--format json|csv] [--out file]" << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    options options;
+    try
+    {
+        for(int i = 1; i < argc; i += 2)
+        {
+            std::string flag = argv[i];
+            if(i + 1 == argc)
+            {
+                std::cerr << "missing value for " << flag << std::endl;
+                return usage(argv[0]);
+            }
+            std::string value = argv[i + 1];
+            if(flag == "--bodies")
+                options.bodies = parseList<uint32_t>(value, parseCount);
+            else if(flag == "--mixes")
+                options.mixes = parseList<std::string>(value, [](const std::string& item) { return item; });
+            else if(flag == "--steps")
+                options.steps = parseCount(value);
+            else if(flag == "--seed")
+                options.seed = parseCount(value);
+            else if(flag == "--threads")
+                options.threads = parseCount(value);
+            else if(flag == "--io-repeats")
+                options.ioRepeats = parseCount(value);
+            else if(flag == "--format")
+                options.format = value;
+            else if(flag == "--out")
+                options.out = value;
+            else
+            {
+                std::cerr << "unknown option " << flag << std::endl;
+                return usage(argv[0]);
+            }
+        }
+    }
+    catch(const std::exception&)
+    {
+        return usage(argv[0]);
+    }
+    // Every scene needs a body, stepsFor divides by the count.
+    bool emptyScene = std::find(options.bodies.begin(), options.bodies.end(), 0u) != options.bodies.end();
+    if(options.bodies.empty() || emptyScene || options.mixes.empty() || options.steps == 0 ||
+       (options.format != "json" && options.format != "csv"))
+        return usage(argv[0]);
+
+    std::vector<result> results;
+    for(const std::string& name : options.mixes)
+    {
+        const shapeMix* mix = std::find_if(std::begin(mixes), std::end(mixes), [&](const shapeMix& candidate) { return name == candidate.name; });
+        if(mix == std::end(mixes))
+        {
+            std::cerr << "unknown mix " << name << std::endl;
+            return 1;
+        }
+        for(uint32_t bodies : options.bodies)
+        {
+            std::cerr << mix->name << ", " << bodies << " bodies, " << stepsFor(options, bodies) << " steps" << std::endl;
+            runScene(options, *mix, bodies, results);
+        }
+    }
+
+    if(options.out.empty())
+    {
+        writeResults(std::cout, options, results);
+    }
+    else
+    {
+        std::ofstream file(options.out);
+        writeResults(file, options, results);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+#ifndef PHYSIM_AABBTREE_H
+#define PHYSIM_AABBTREE_H
+
+#include "common.h"
+#include "broadphase.h"
+
+namespace kq
+{
+
+// Incrementally updated bounding volume hierarchy. Leaves store fattened bounds, so a proxy
+// is only reinserted once its body leaves the fat box, which is rare for slow moving bodies.
+class aabbTree
+{
+public:
+    static constexpr int32_t nullNode = -1;
+
+    aabbTree(float margin);
+
+    int32_t createProxy(const AABB& bounds, uint32_t userData);
+    void destroyProxy(int32_t proxy);
+    // Returns true if the proxy had to be reinserted. The displacement extends the fat box in
+    // the direction of travel so the next few steps stay inside it.
+    bool moveProxy(int32_t proxy, const AABB& bounds, vector2f displacement);
+    void clear();
+
+    const AABB& getFatBounds(int32_t proxy) const;
+    uint32_t getUserData(int32_t proxy) const;
+    int32_t getHeight() const;
+    float getMargin() const;
+    void setMargin(float margin);
+
+    // The callback receives the user data of every leaf whose fat bounds overlap the query
+    // and returns false to stop the traversal.
+    template<typename Callback>
+    void query(const AABB& bounds, Callback&& callback) const;
+    template<typename Callback>
+    void queryPoint(vector2f point, Callback&& callback) const;
+
+    // bounds[i] are the tight bounds of the proxy whose user data is i. Each overlapping pair
+    // is appended once, with first < second. Sleeping bodies are not queried, they are only
+    // found by the awake bodies touching them.
+    void findPairs(const std::vector<AABB>& bounds, const std::vector<uint8_t>& asleep, std::vector<collisionPair>& pairs) const;
+
+private:
+    struct node
+    {
+        AABB bounds;
+        int32_t parent; // next free node while the node is unused
+        int32_t child1;
+        int32_t child2;
+        int32_t height; // leaves are 0, free nodes -1
+        uint32_t userData;
+
+        bool isLeaf() const { return child1 == nullNode; }
+    };
+
+    // Traversal stack that only touches the heap for degenerate trees.
+    class nodeStack
+    {
+    public:
+        nodeStack() : m_size(0), m_spill() {}
+        void push(int32_t index)
+        {
+            if(m_size < fixedCapacity)
+                m_fixed[m_size] = index;
+            else
+                m_spill.push_back(index);
+            ++m_size;
+        }
+        int32_t pop()
+        {
+            --m_size;
+            if(m_size < fixedCapacity)
+                return m_fixed[m_size];
+            int32_t index = m_spill.back();
+            m_spill.pop_back();
+            return index;
+        }
+        bool empty() const { return m_size == 0; }
+    private:
+        static constexpr size_t fixedCapacity = 128;
+        int32_t m_fixed[fixedCapacity];
+        size_t m_size;
+        std::vector<int32_t> m_spill;
+    };
+
+    int32_t allocateNode();
+    void freeNode(int32_t index);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t index);
+    void refit(int32_t index);
+
+    static AABB combine(const AABB& a, const AABB& b);
+    static float perimeter(const AABB& bounds);
+
+    std::vector<node> m_nodes;
+    int32_t m_root;
+    int32_t m_freeList;
+    float m_margin;
+};
+
+template<typename Callback>
+void aabbTree::query(const AABB& bounds, Callback&& callback) const
+{
+    if(m_root == nullNode)
+        return;
+    nodeStack stack;
+    stack.push(m_root);
+    while(!stack.empty())
+    {
+        const node& current = m_nodes[stack.pop()];
+        if(!current.bounds.overlaps(bounds))
+            continue;
+        if(current.isLeaf())
+        {
+            if(!callback(current.userData))
+                return;
+        }
+        else
+        {
+            stack.push(current.child1);
+            stack.push(current.child2);
+        }
+    }
+}
+
+template<typename Callback>
+void aabbTree::queryPoint(vector2f point, Callback&& callback) const
+{
+    query(AABB{point, point}, std::forward<Callback>(callback));
+}
+
+} // namespace kq
+
+#endif
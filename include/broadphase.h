@@ -0,0 +1,46 @@
+#ifndef PHYSIM_BROADPHASE_H
+#define PHYSIM_BROADPHASE_H
+
+#include "common.h"
+
+namespace kq
+{
+
+struct collisionPair
+{
+    uint32_t first;
+    uint32_t second;
+};
+
+// Uniform grid broadphase. Cells are addressed by their packed (x, y) coordinates,
+// so the grid has no fixed extent and only occupied cells cost memory.
+class spatialGrid
+{
+public:
+    spatialGrid(float cellSize);
+
+    void setCellSize(float cellSize);
+    float getCellSize() const;
+
+    // Bins every bound into the cells it overlaps and appends each overlapping pair once,
+    // with first < second. Pairs of two sleeping bodies are left out.
+    void findPairs(const std::vector<AABB>& bounds, const std::vector<uint8_t>& asleep, std::vector<collisionPair>& pairs);
+
+private:
+    struct cellEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    int32_t cellCoord(float value) const;
+    static uint64_t cellKey(int32_t x, int32_t y);
+
+    float m_cellSize;
+    float m_invCellSize;
+    std::vector<cellEntry> m_entries;
+};
+
+} // namespace kq
+
+#endif
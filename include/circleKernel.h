@@ -0,0 +1,38 @@
+#ifndef PHYSIM_CIRCLEKERNEL_H
+#define PHYSIM_CIRCLEKERNEL_H
+
+#include <cstdint>
+
+namespace kq
+{
+
+namespace circleKernel
+{
+
+constexpr uint32_t batchSize = 8;
+
+enum class instructionSet : int
+{
+    Scalar = 0,
+    SSE = 1,
+    AVX2 = 2
+};
+
+// Tests one circle against up to batchSize candidates stored in separate coordinate arrays of
+// batchSize floats. Bit i of the result is set when candidate i overlaps the circle; lanes at
+// or past count are ignored.
+using batchFunction = uint32_t(*)(float x, float y, float radius,
+                                  const float* xs, const float* ys, const float* radii, uint32_t count);
+
+// The widest kernel the CPU supports, detected on first use.
+instructionSet getInstructionSet();
+const char* getInstructionSetName(instructionSet set);
+batchFunction getBatchFunction(instructionSet set);
+
+uint32_t testBatch(float x, float y, float radius, const float* xs, const float* ys, const float* radii, uint32_t count);
+
+} // namespace circleKernel
+
+} // namespace kq
+
+#endif
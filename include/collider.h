@@ -0,0 +1,93 @@
+#ifndef PHYSIM_COLLIDER_H
+#define PHYSIM_COLLIDER_H
+
+#include "common.h"
+#include "world.h"
+#include "broadphase.h"
+#include "aabbTree.h"
+#include "narrowphase.h"
+#include "geometryCache.h"
+#include "circleKernel.h"
+
+namespace kq
+{
+
+enum class broadphaseType : int
+{
+    BruteForce = 0,
+    Grid = 1,
+    Tree = 2
+};
+
+// Runs the broadphase and the narrowphase. BruteForce skips the broadphase and tests every
+// pair, it is kept to compare results against the accelerated paths.
+class collider
+{
+public:
+    collider();
+
+    broadphaseType& getBroadphase();
+    float getCellSize() const;
+    void setCellSize(float cellSize);
+    float getTreeMargin() const;
+    void setTreeMargin(float margin);
+    int32_t getTreeHeight() const;
+    // Circle pairs are tested several at a time with the widest SIMD kernel the CPU supports.
+    bool& getBatchedCircles();
+
+    // Pairs come from the bounds swept over the last step, so a fast body also meets the bodies
+    // it passed, see continuousCollider. Bounds and outlines are read from the step's geometry.
+    const std::vector<collisionPair>& findPairs(const world& world, const geometryCache& geometry);
+    const std::vector<collisionPair>& getPairs() const;
+
+    // Tests each pair once and records the touching ones. The buffer keeps its capacity between
+    // steps, so detection does not allocate once a scene has settled.
+    const std::vector<contact>& findContacts(const world& world, const geometryCache& geometry);
+    // Narrowphase only: tests the pairs found by the last findPairs.
+    const std::vector<contact>& testPairs(const world& world, const geometryCache& geometry);
+    const std::vector<contact>& getContacts() const;
+    // GJK simplices of the polygon pairs tested in the last step, see narrowphase::simplexCache.
+    const narrowphase::simplexCache& getSimplexCache() const;
+
+    // Spatial queries go through the AABB tree whatever the broadphase mode is. The tree is
+    // brought up to date from the world first, which only reinserts bodies that left their fat
+    // bounds; queries may run between steps, after the geometry cache was built.
+    void queryPoint(const world& world, vector2f point, std::vector<uint32_t>& result);
+    void queryRegion(const world& world, const AABB& region, std::vector<uint32_t>& result);
+
+private:
+    // Consecutive circle pairs sharing their first body, waiting for the SIMD kernel.
+    struct circleBatch
+    {
+        uint32_t first;
+        uint32_t count;
+        uint32_t seconds[circleKernel::batchSize];
+        float xs[circleKernel::batchSize];
+        float ys[circleKernel::batchSize];
+        float radii[circleKernel::batchSize];
+    };
+
+    void testPair(const world& world, const geometryCache& geometry, uint32_t first, uint32_t second);
+    void flushCircleBatch(const world& world);
+    void updateTree(const world& world);
+    void updateTree(const world& world, const std::vector<AABB>& bounds);
+
+    broadphaseType m_broadphase;
+    spatialGrid m_grid;
+    aabbTree m_tree;
+    std::vector<int32_t> m_proxies;
+    // The body each proxy was created for, to notice an index taken over by another body.
+    std::vector<bodyHandle> m_proxyHandles;
+    // Bounds the tree proxies were last moved to.
+    std::vector<AABB> m_bounds;
+    std::vector<AABB> m_queryBounds;
+    std::vector<collisionPair> m_pairs;
+    std::vector<contact> m_contacts;
+    narrowphase::simplexCache m_simplices;
+    bool m_batchedCircles;
+    circleBatch m_circleBatch;
+};
+
+} // namespace kq
+
+#endif
@@ -8,12 +8,12 @@
 #include <initializer_list>
 #include <memory>
 #include <exception>
+#include <array>
+#include <string>
+#include <cstdint>
 
-#include <SFML/Graphics.hpp>
-#include "imgui.h"
-#include "imgui-SFML.h"
-
-
+// The simulation core only depends on the standard library, so it can be built without SFML or
+// ImGui. The front end converts these types to their SFML counterparts, see renderer.h.
 
 namespace kq
 {
@@ -53,6 +53,73 @@ inline std::string itos(int conv)
         Triangle = 3,
         Convex = 4
     };
+
+// Same layout and operators as sf::Vector2.
+template<typename T>
+struct vector2
+{
+    T x;
+    T y;
+
+    constexpr vector2() : x(0), y(0) {}
+    constexpr vector2(T x, T y) : x(x), y(y) {}
+    template<typename U>
+    constexpr explicit vector2(const vector2<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+
+    constexpr vector2 operator-() const { return {-x, -y}; }
+    constexpr vector2 operator+(const vector2& other) const { return {x + other.x, y + other.y}; }
+    constexpr vector2 operator-(const vector2& other) const { return {x - other.x, y - other.y}; }
+    constexpr vector2 operator*(T scalar) const { return {x * scalar, y * scalar}; }
+    constexpr vector2 operator/(T scalar) const { return {x / scalar, y / scalar}; }
+    vector2& operator+=(const vector2& other) { x += other.x; y += other.y; return *this; }
+    vector2& operator-=(const vector2& other) { x -= other.x; y -= other.y; return *this; }
+    vector2& operator*=(T scalar) { x *= scalar; y *= scalar; return *this; }
+    vector2& operator/=(T scalar) { x /= scalar; y /= scalar; return *this; }
+    constexpr bool operator==(const vector2& other) const { return x == other.x && y == other.y; }
+    constexpr bool operator!=(const vector2& other) const { return !(*this == other); }
+};
+
+template<typename T>
+constexpr vector2<T> operator*(T scalar, const vector2<T>& vector) { return vector * scalar; }
+
+using vector2f = vector2<float>;
+using vector2i = vector2<int>;
+
+// 8-bit RGBA color, same layout as sf::Color.
+struct rgba
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+
+    constexpr rgba() : r(0), g(0), b(0), a(255) {}
+    constexpr rgba(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255) : r(red), g(green), b(blue), a(alpha) {}
+};
+
+struct AABB
+{
+    vector2f min;
+    vector2f max;
+
+    bool overlaps(const AABB& other) const
+    {
+        return min.x <= other.max.x && other.min.x <= max.x &&
+               min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    bool contains(vector2f point) const
+    {
+        return point.x >= min.x && point.x <= max.x &&
+               point.y >= min.y && point.y <= max.y;
+    }
+
+    bool contains(const AABB& other) const
+    {
+        return min.x <= other.min.x && min.y <= other.min.y &&
+               other.max.x <= max.x && other.max.y <= max.y;
+    }
+};
 }
 
 #endif
\ No newline at end of file
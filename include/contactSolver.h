@@ -0,0 +1,91 @@
+#ifndef PHYSIM_CONTACTSOLVER_H
+#define PHYSIM_CONTACTSOLVER_H
+
+#include "common.h"
+#include "world.h"
+#include "narrowphase.h"
+#include "threadPool.h"
+#include <unordered_map>
+
+namespace kq
+{
+
+// Sequential impulses: every iteration applies to each contact the impulse that brings its
+// approach speed to the target, clamping the total pushed so far so contacts only ever push.
+// Each pair keeps its total in a manifold between steps and starts the next step by applying
+// it again, so a resting stack begins already holding its weight and settles in a few
+// iterations. Bodies do not rotate, so one point along the normal is the whole manifold.
+//
+// Contacts are greedily colored so that no two contacts of a color share a body; each color is
+// then a batch whose contacts can be resolved concurrently.
+class contactSolver
+{
+public:
+    static constexpr uint32_t maxColors = 64;
+    // Penetration left uncorrected so resting contacts stay touching and keep their manifold.
+    static constexpr float slop = 0.5f;
+    // Fraction of the remaining penetration pushed out per step.
+    static constexpr float baumgarte = 0.2f;
+    // Approach speed below which contacts do not bounce, so resting bodies come to rest.
+    static constexpr float restitutionThreshold = 25.f;
+
+    struct manifold
+    {
+        // Oriented from the lower handle slot to the higher one.
+        vector2f normal = {0.f, 0.f};
+        float normalImpulse = 0.f;
+        uint32_t firstGeneration = 0;
+        uint32_t secondGeneration = 0;
+        uint32_t step = 0;
+    };
+
+    contactSolver();
+
+    void solve(world& world, const std::vector<contact>& contacts, threadPool& pool, float deltaTime);
+    // Forgets every manifold, so the next step starts cold.
+    void clear();
+
+    int& getIterations();
+    bool& getWarmStarting();
+    // Colors used by the last solve, including the serial overflow batch if it was needed.
+    uint32_t getColorCount() const;
+    size_t getManifoldCount() const;
+
+private:
+    struct constraint
+    {
+        uint32_t first;
+        uint32_t second;
+        vector2f normal;
+        float invMassFirst;
+        float invMassSecond;
+        float mass;
+        float bias;
+        float impulse;
+        manifold* persistent;
+    };
+
+    void colorContacts(uint32_t bodyCount, const std::vector<contact>& contacts);
+    void prepare(world& world, float deltaTime);
+    template<typename Function>
+    void forEachBatch(threadPool& pool, Function&& function);
+
+    std::vector<uint64_t> m_bodyColors;
+    std::vector<uint8_t> m_contactColors;
+    // Contacts sorted by color; batch c is [m_batchOffsets[c], m_batchOffsets[c + 1]).
+    // Batch maxColors holds the contacts that found no free color and is resolved serially.
+    std::vector<contact> m_ordered;
+    std::vector<uint32_t> m_batchOffsets;
+    // One per ordered contact.
+    std::vector<constraint> m_constraints;
+    // Keyed by the bodies' handle slots, lower first; pairs that stop touching are dropped.
+    std::unordered_map<uint64_t, manifold> m_manifolds;
+    uint32_t m_colorCount;
+    uint32_t m_step;
+    int m_iterations;
+    bool m_warmStarting;
+};
+
+} // namespace kq
+
+#endif
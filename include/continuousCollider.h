@@ -0,0 +1,53 @@
+#ifndef PHYSIM_CONTINUOUSCOLLIDER_H
+#define PHYSIM_CONTINUOUSCOLLIDER_H
+
+#include "common.h"
+#include "world.h"
+#include "broadphase.h"
+
+namespace kq
+{
+
+// Stops fast bodies at their first time of impact in a step, so they cannot pass through each
+// other between two steps. A body is fast when it travelled further than its inner radius.
+// Each candidate pair holding a fast body is swept as two moving inner circles; both bodies of
+// the earliest hit are moved back along their step to where the circles touch, which leaves
+// the real shapes slightly overlapping so the narrowphase resolves the contact as usual. The
+// rest of the step is dropped for those bodies.
+class continuousCollider
+{
+public:
+    continuousCollider();
+
+    // Runs after integration and the broadphase. The broadphase bounds must cover the whole
+    // step's motion, see world::getSweptBounds.
+    void solve(world& world, const std::vector<collisionPair>& pairs);
+    // Brute force has no pairs, every fast body is swept against every other body.
+    void solveAll(world& world);
+
+    bool& getEnabled();
+    uint32_t getFastCount() const;
+    uint32_t getImpactCount() const;
+    // Bodies the last solve moved back to their time of impact.
+    const std::vector<uint32_t>& getRewound() const;
+
+    static float innerRadius(const world& world, uint32_t index);
+
+private:
+    bool findFastBodies(const world& world);
+    void sweep(const world& world, uint32_t first, uint32_t second);
+    void rewind(world& world);
+
+    bool m_enabled;
+    uint32_t m_fastCount;
+    uint32_t m_impactCount;
+    std::vector<uint8_t> m_fast;
+    std::vector<uint32_t> m_fastBodies;
+    // Earliest time of impact of each body as a fraction of the step, 1 for no impact.
+    std::vector<float> m_impacts;
+    std::vector<uint32_t> m_hitBodies;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PHYSIM_DRAWBATCH_H
+#define PHYSIM_DRAWBATCH_H
+
+#include "common.h"
+#include "world.h"
+#include "geometryCache.h"
+#include "threadPool.h"
+
+namespace kq
+{
+
+// Same layout as sf::Vertex, so the front end can submit the buffer without a copy.
+struct vertex
+{
+    vector2f position;
+    rgba color;
+    vector2f texCoords;
+};
+
+// A triangle list for the bodies of a world, built on the CPU without SFML so it can also be timed
+// and used headless. Only the given candidates are walked, so the cost follows what is on screen
+// rather than the size of the world. Every candidate owns a fixed range of the buffer, so the
+// fill runs in parallel. Candidates outside the visible region get an empty range, and bodies
+// smaller than pointSize go to a separate point list instead of being tessellated.
+class drawBatch
+{
+public:
+    drawBatch();
+
+    // One triangle list for every visible candidate, placed between its last two steps by
+    // interpolation. Candidates are indices in increasing order, later bodies are drawn on top.
+    // Polygon outlines are read from geometry, which must hold every body of the world.
+    void fill(const world& world, const geometryCache& geometry, const std::vector<uint32_t>& candidates,
+              float interpolation, threadPool& pool, const AABB& visible, float pointSize);
+    // Appends a ring of the given thickness around a body, outside its shape like an SFML outline.
+    void addOutline(const world& world, const geometryCache& geometry, uint32_t index, float interpolation,
+                    float thickness, rgba color);
+    void clear();
+
+    const std::vector<vertex>& getVertices() const;
+    const std::vector<vertex>& getPoints() const;
+
+    static uint32_t getVertexCount(const world& world, const geometryCache& geometry, uint32_t index);
+
+private:
+    std::vector<vertex> m_vertices;
+    std::vector<vertex> m_points;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_pointOffsets;
+};
+
+} // namespace kq
+
+#endif
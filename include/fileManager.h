@@ -1,5 +1,7 @@
 #pragma once
 
+#include "common.h"
+#include "sceneWriter.h"
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -8,15 +10,56 @@
 namespace kq
 {
 
-class physicalObject;
-class physim;
+class simulation;
 
 class fileManager {
 public:
-    fileManager(physim* parent) : parent(parent) {}
-    physim* parent;
-    bool loadcsv(const std::string& filename, std::vector<physicalObject*>& objects);
-    bool savecsv(const std::string& filename, const std::vector<physicalObject*>& objects);
+    fileManager(simulation* parent) : parent(parent), m_errors() {}
+    simulation* parent;
+    // Maps the file and parses it in chunks of whole rows on the simulation's thread pool.
+    // Malformed rows are skipped and reported in getErrors; false only if the file cannot be read.
+    bool loadcsv(const std::string& filename);
+    bool savecsv(const std::string& filename);
+    // Binary snapshots, see snapshot.h. Loading also restores the world size.
+    bool loadSnapshot(const std::string& filename);
+    bool saveSnapshot(const std::string& filename);
+
+    // load picks the format from the file's magic number, save from the extension: snapshotExtension
+    // writes a snapshot, anything else CSV.
+    bool load(const std::string& filename);
+    bool save(const std::string& filename);
+    static fileFormat detectFormat(const std::string& filename);
+    static fileFormat formatFromExtension(const std::string& filename);
+
+    static constexpr const char* snapshotExtension = ".psnap";
+
+    struct parseError
+    {
+        uint64_t line;
+        std::string message;
+    };
+    // Rows skipped by the last load, with their line numbers.
+    const std::vector<parseError>& getErrors() const;
+
+private:
+    // Bodies parsed from one chunk; line numbers are relative to the chunk until merged.
+    struct csvChunk
+    {
+        std::vector<vector2f> positions;
+        std::vector<vector2f> velocities;
+        std::vector<float> masses;
+        std::vector<objectType> types;
+        std::vector<vector2f> extents;
+        std::vector<rgba> colors;
+        // One per convex body, in row order.
+        std::vector<polygon> polygons;
+        std::vector<parseError> errors;
+        uint64_t lines = 0;
+    };
+
+    static void parseChunk(const char* begin, const char* end, csvChunk& chunk);
+
+    std::vector<parseError> m_errors;
 };
 
 }
@@ -0,0 +1,69 @@
+#ifndef PHYSIM_GEOMETRYCACHE_H
+#define PHYSIM_GEOMETRYCACHE_H
+
+#include "common.h"
+#include "world.h"
+#include "threadPool.h"
+
+namespace kq
+{
+
+// World-space outline of one polygonal body: its vertices in order and, for the edge starting at
+// each, the outward normal and the edge's distance from the origin along it, so a point p lies
+// outside edge i by dot(normals[i], p) - distances[i].
+struct shapeView
+{
+    const vector2f* vertices;
+    const vector2f* normals;
+    const float* distances;
+    uint32_t count;
+
+    // Index of the vertex farthest along direction.
+    uint32_t support(vector2f direction) const;
+};
+
+// Every body's geometry placed in the world once per step, after integration, so the
+// broadphase, the narrowphase and the renderer read it instead of each rebuilding vertices
+// from the extents. Polygons own a contiguous range of the vertex arrays; circles own an empty
+// one and are read from the world's position and radius.
+class geometryCache
+{
+public:
+    geometryCache();
+
+    // Places every body. The vertex ranges are only laid out again when the world's revision
+    // changed, the rest runs in parallel on the pool.
+    void update(const world& world, threadPool& pool);
+    // Places again the given bodies after they were moved within the step, see continuousCollider.
+    void refresh(const world& world, const std::vector<uint32_t>& bodies);
+
+    // The world revision the ranges were laid out for.
+    uint64_t getRevision() const;
+    uint32_t size() const;
+
+    const std::vector<AABB>& getBounds() const;
+    // Covers each body at the previous step and the current one, see world::getSweptBounds.
+    const std::vector<AABB>& getSweptBounds() const;
+    // Where each body was when it was placed; vertices minus this give the local outline.
+    const std::vector<vector2f>& getPositions() const;
+    shapeView getShape(uint32_t index) const;
+    uint32_t getVertexCount(uint32_t index) const;
+
+private:
+    void layout(const world& world);
+    void place(const world& world, uint32_t index);
+
+    // First vertex of each body, one past the end for the last.
+    std::vector<uint32_t> m_offsets;
+    std::vector<vector2f> m_vertices;
+    std::vector<vector2f> m_normals;
+    std::vector<float> m_distances;
+    std::vector<vector2f> m_positions;
+    std::vector<AABB> m_bounds;
+    std::vector<AABB> m_sweptBounds;
+    uint64_t m_revision;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef PHYSIM_ISLANDMANAGER_H
+#define PHYSIM_ISLANDMANAGER_H
+
+#include "common.h"
+#include "world.h"
+#include "narrowphase.h"
+
+namespace kq
+{
+
+// Puts resting bodies to sleep. Bodies joined by contacts form an island, and an island only
+// sleeps once every body in it has stayed below the sleep speed for the sleep time, so a pile
+// goes to sleep as a whole. An island holding an awake, moving body wakes all of its sleepers.
+// Pairs of two sleepers are not generated, so a disturbance wakes a sleeping pile one layer
+// of contacts per step.
+class islandManager
+{
+public:
+    islandManager();
+
+    // Runs after the contacts of a step have been resolved.
+    void update(world& world, const std::vector<contact>& contacts, float deltaTime);
+
+    bool& getEnabled();
+    float& getSleepSpeed();
+    float& getSleepTime();
+    uint32_t getSleepingCount() const;
+
+private:
+    uint32_t find(uint32_t index);
+    void unite(uint32_t first, uint32_t second);
+
+    bool m_enabled;
+    float m_sleepSpeed;
+    float m_sleepTime;
+    uint32_t m_sleeping;
+    // Union-find over body indices, rebuilt every step.
+    std::vector<uint32_t> m_parents;
+    std::vector<uint8_t> m_canSleep;
+};
+
+} // namespace kq
+
+#endif
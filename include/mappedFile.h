@@ -0,0 +1,41 @@
+#ifndef PHYSIM_MAPPEDFILE_H
+#define PHYSIM_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace kq
+{
+
+// A whole file mapped read-only into memory, so loaders can read it in place without copying
+// it through a stream first.
+class mappedFile
+{
+public:
+    mappedFile();
+    ~mappedFile();
+
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const;
+    // Null for an empty file.
+    const char* data() const;
+    size_t size() const;
+
+private:
+    bool m_open;
+    const char* m_data;
+    size_t m_size;
+#if defined(_WIN32)
+    void* m_file;
+    void* m_mapping;
+#endif
+};
+
+} // namespace kq
+
+#endif
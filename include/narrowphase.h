@@ -0,0 +1,85 @@
+#ifndef PHYSIM_NARROWPHASE_H
+#define PHYSIM_NARROWPHASE_H
+
+#include "common.h"
+#include <unordered_map>
+
+namespace kq
+{
+
+class physicalObject;
+class world;
+class geometryCache;
+
+// A touching pair of bodies. The normal points from first to second.
+struct contact
+{
+    uint32_t first;
+    uint32_t second;
+    vector2f normal;
+    float penetration;
+    objectType firstType;
+    objectType secondType;
+};
+
+namespace narrowphase
+{
+
+constexpr size_t typeCount = 5;
+// Polygon pairs with at most this many vertices between them are separated with SAT, larger
+// ones with GJK and EPA.
+constexpr uint32_t satVertexLimit = 8;
+
+// The GJK simplex each polygon pair ended on, kept between steps. A pair that stays in contact
+// starts its next search from the same support points, which usually still enclose the origin,
+// so GJK finishes in one or two iterations instead of rebuilding the simplex from scratch.
+class simplexCache
+{
+public:
+    struct simplex
+    {
+        uint32_t count = 0;
+        uint8_t first[3];
+        uint8_t second[3];
+        uint32_t step = 0;
+    };
+
+    simplexCache();
+
+    // Keyed by the bodies' handle slots, which survive index moves. A recycled slot only
+    // costs a poor starting simplex, the indices are checked against the polygons.
+    simplex& get(uint32_t firstSlot, uint32_t secondSlot);
+    // Drops the simplices of pairs that were not tested since the last call.
+    void endStep();
+    void clear();
+    size_t size() const;
+
+private:
+    std::unordered_map<uint64_t, simplex> m_simplices;
+    uint32_t m_step;
+};
+
+using testFunction = bool(*)(const physicalObject&, const physicalObject&, contact&, simplexCache*);
+
+// Returns the test for a pair of type tags. The matrix is generated at compile time; the
+// (B, A) entries swap their arguments and reuse the (A, B) test, so each shape pair is
+// implemented once.
+testFunction getTest(objectType a, objectType b);
+
+// Fills result when the bodies touch. The test is symmetric: collide(a, b) and collide(b, a)
+// agree, so every pair only needs to be tested once. Circles against polygons and small polygon
+// pairs use SAT; larger polygon pairs use GJK and EPA, warm started from cache when given.
+bool collide(const physicalObject& a, const physicalObject& b, contact& result, simplexCache* cache = nullptr);
+bool collide(const physicalObject& a, const physicalObject& b);
+// The same tests by index, reading the placed outlines from the step's geometry cache.
+bool collide(const world& world, const geometryCache& geometry, uint32_t first, uint32_t second, contact& result,
+             simplexCache* cache = nullptr);
+
+// Contact for two circles already known to overlap, built straight from the world arrays.
+void circleContact(const world& world, uint32_t first, uint32_t second, contact& result);
+
+} // namespace narrowphase
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef PHYSIM_OBJECTPOOL_H
+#define PHYSIM_OBJECTPOOL_H
+
+#include "types.h"
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace kq
+{
+
+// Storage for the shape objects. The shapes are views onto the world and only differ in their
+// vtable, so they share one size of slot. Slots are handed out from blocks of blockSize and
+// reused through a free list, so creating a body does not go to the heap once the pool has
+// grown, and reset drops every slot at once.
+class objectPool
+{
+public:
+    static constexpr uint32_t blockSize = 4096;
+
+    objectPool();
+
+    objectPool(const objectPool&) = delete;
+    objectPool& operator=(const objectPool&) = delete;
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(std::is_base_of_v<physicalObject, T>, "the pool only holds shapes");
+        static_assert(sizeof(T) <= sizeof(slot) && alignof(T) <= alignof(slot), "shape does not fit a pool slot");
+        return new(allocate()) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(physicalObject* object);
+    // Frees every slot. The objects must have been destroyed already.
+    void reset();
+
+private:
+    struct slot
+    {
+        alignas(Circle) alignas(Square) alignas(Rectangle) alignas(Triangle) alignas(Convex)
+        unsigned char bytes[std::max({sizeof(Circle), sizeof(Square), sizeof(Rectangle), sizeof(Triangle), sizeof(Convex)})];
+    };
+
+    void* allocate();
+
+    std::vector<std::unique_ptr<slot[]>> m_blocks;
+    std::vector<void*> m_free;
+    // Slots below this in the blocks have been handed out at some point.
+    size_t m_used;
+};
+
+} // namespace kq
+
+#endif
@@ -2,10 +2,15 @@
 #define PHYSIM_H
 
 #include "common.h"
-#include "types.h"
+#include "simulation.h"
+#include "simulationThread.h"
+#include "renderer.h"
 #include "uimanager.h"
-#include "collider.h"
-#include "fileManager.h"
+#include <SFML/Graphics.hpp>
+#include "imgui.h"
+#include "imgui-SFML.h"
+#include <atomic>
+#include <memory>
 
 namespace kq
 {
@@ -17,31 +22,58 @@ public:
     ~physim();
     
     void run();
-    const std::vector<physicalObject*>& getEntities() const;
-    std::vector<physicalObject*>& getEntities();
-    fileManager& getFileManager();
-    void clearEntities();
-    void Impulse();
-    void createObject(objectType type, float rotation, float radius, sf::Vector2f size,
-                 sf::Vector2f velocity, std::array<float, 4> colors, float mass);
+    // The state the current frame draws and shows, see simulationThread.
+    const simulationState& getState() const;
+    // Changes to the simulation go through here once run has started.
+    simulationThread& getSimulationThread();
+    // Thread safe, see profiler.
+    profiler& getProfiler();
+    // What the simulation's pool may use, the rest of the hardware threads draw.
+    uint32_t getMaxSimulationThreads() const;
+    // Fits the whole world in the window.
+    void resetCamera();
+    void createObject(objectType type, float rotation, float radius, vector2f size, int sides,
+                 vector2f velocity, std::array<float, 4> colors, float mass);
 
 private:
+    void pollEvents();
     void drawObjects();
-    void updateObjects(float deltaTime);
+    void updateObjects();
+    // The point is looked up in the collider's tree on the simulation thread, the body is
+    // selected once a later frame sees the result.
+    void selectAt(vector2f point);
+    void zoomCamera(float delta, sf::Vector2i pixel);
+    vector2f toWorld(sf::Vector2i pixel) const;
+    AABB getViewBounds() const;
     void mainMenu();
 
-    
+    // A pick running on the simulation thread; done is set once body is filled in.
+    struct pickResult
+    {
+        std::atomic<bool> done{false};
+        bodyHandle body;
+    };
 
-    
 
     uint16_t m_width;
     uint16_t m_height;
     sf::RenderWindow m_window;
+    // Pans with the middle mouse button and zooms around the cursor with the wheel.
+    sf::View m_camera;
+    bool m_panning;
+    sf::Vector2i m_panStart;
 
     UIManager m_UIManager;
 
-    std::vector<physicalObject*> m_entities;
-    fileManager m_fileManager;
+    simulation m_simulation;
+    // Owns the simulation once run starts; declared after it so it stops first.
+    simulationThread m_simulationThread;
+    const simulationState* m_state;
+    std::shared_ptr<pickResult> m_pick;
+    renderer m_renderer;
+    // The simulation's pool is busy on its own thread, drawing fills its batches on this one.
+    // The two split the hardware threads between them.
+    threadPool m_drawPool;
 };
 
 } // namespace kq
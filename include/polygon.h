@@ -0,0 +1,40 @@
+#ifndef PHYSIM_POLYGON_H
+#define PHYSIM_POLYGON_H
+
+#include "common.h"
+#include <array>
+
+namespace kq
+{
+
+// A convex polygon in local space, centered on its centroid. Vertices wind so that the edge
+// from vertices[i] to vertices[i + 1] has (edge.y, -edge.x) as its outward normal, the same
+// order the renderer fans its triangles in.
+struct polygon
+{
+    static constexpr uint32_t maxVertices = 8;
+
+    uint32_t count = 0;
+    std::array<vector2f, maxVertices> vertices;
+    // Outward unit normal of the edge starting at each vertex.
+    std::array<vector2f, maxVertices> normals;
+
+    // The built-in shapes, with the placement of world::localBounds.
+    static polygon box(vector2f size);
+    static polygon triangle(float side);
+    static polygon regular(uint32_t sides, float radius, float rotation);
+    // Convex hull of the points, moved so its centroid is the origin; centroid, if given,
+    // receives where it was. False if the hull is degenerate or has more than maxVertices.
+    static bool hull(const vector2f* points, uint32_t count, polygon& result, vector2f* centroid = nullptr);
+
+    void computeNormals();
+    AABB getBounds() const;
+    // Distance from the centroid to the nearest edge.
+    float getInnerRadius() const;
+    // Index of the vertex farthest along direction.
+    uint32_t support(vector2f direction) const;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef PHYSIM_PROFILER_H
+#define PHYSIM_PROFILER_H
+
+#include "common.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace kq
+{
+
+enum class profilePhase : int
+{
+    Frame = 0,
+    Events,
+    Update,
+    Integrate,
+    Geometry,
+    Broadphase,
+    TimeOfImpact,
+    Narrowphase,
+    Resolve,
+    Islands,
+    Draw,
+    UI,
+    Render,
+    Display,
+    Count
+};
+
+// Per-phase frame timings kept in a ring buffer of the last historySize frames. A phase that
+// runs several times in a frame, like the simulation steps, adds up; steps run on the simulation
+// thread and count towards the frame they finish in. While disabled, scopes only test a flag and
+// read no clock. The history is read by the thread that ends the frames.
+class profiler
+{
+public:
+    static constexpr uint32_t historySize = 240;
+    static constexpr uint32_t phaseCount = static_cast<uint32_t>(profilePhase::Count);
+
+    using clock = std::chrono::steady_clock;
+
+    // Adds the time between its construction and destruction to a phase of the current frame.
+    class scope
+    {
+    public:
+        scope(profiler& profiler, profilePhase phase);
+        ~scope();
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        profiler* m_profiler;
+        profilePhase m_phase;
+        clock::time_point m_start;
+    };
+
+    profiler();
+
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    void beginFrame();
+    void endFrame();
+    void add(profilePhase phase, float milliseconds);
+    void setCounts(uint32_t bodies, uint32_t pairs, uint32_t contacts);
+
+    // Milliseconds per phase, oldest first starting at getHistoryOffset().
+    const float* getHistory(profilePhase phase) const;
+    uint32_t getHistoryOffset() const;
+    uint32_t getFrameCount() const;
+    float getAverage(profilePhase phase) const;
+    float getPercentile(profilePhase phase, float fraction) const;
+
+    uint32_t getBodies() const;
+    uint32_t getPairs() const;
+    uint32_t getContacts() const;
+
+    static const char* getPhaseName(profilePhase phase);
+
+private:
+    std::atomic<bool> m_enabled;
+    // Guards the current frame, which both threads add to.
+    std::mutex m_mutex;
+    clock::time_point m_frameStart;
+    float m_current[phaseCount];
+    float m_history[phaseCount][historySize];
+    uint32_t m_head;
+    uint32_t m_frames;
+
+    std::atomic<uint32_t> m_bodies;
+    std::atomic<uint32_t> m_pairs;
+    std::atomic<uint32_t> m_contacts;
+};
+
+inline profiler::scope::scope(profiler& profiler, profilePhase phase)
+    : m_profiler(profiler.isEnabled() ? &profiler : nullptr), m_phase(phase), m_start()
+{
+    if(m_profiler)
+        m_start = clock::now();
+}
+
+inline profiler::scope::~scope()
+{
+    if(m_profiler)
+        m_profiler->add(m_phase, std::chrono::duration<float, std::milli>(clock::now() - m_start).count());
+}
+
+inline bool profiler::isEnabled() const { return m_enabled; }
+
+} // namespace kq
+
+#endif
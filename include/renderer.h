@@ -0,0 +1,46 @@
+#ifndef PHYSIM_RENDERER_H
+#define PHYSIM_RENDERER_H
+
+#include "common.h"
+#include "world.h"
+#include "drawBatch.h"
+#include "threadPool.h"
+#include <SFML/Graphics.hpp>
+
+namespace kq
+{
+
+inline sf::Vector2f toSFML(vector2f vector) { return {vector.x, vector.y}; }
+inline sf::Color toSFML(rgba color) { return {color.r, color.g, color.b, color.a}; }
+inline vector2f fromSFML(sf::Vector2f vector) { return {vector.x, vector.y}; }
+
+// Draws the bodies of a world. Drawing lives in the front end so the simulation core does not
+// depend on SFML.
+class renderer
+{
+public:
+    renderer();
+
+    // Draws through the window's current view. Only the candidates are walked, see
+    // simulationState::visible, and of them only those inside the view are submitted: full
+    // shapes in one draw call from a batch filled in parallel on the pool, bodies under
+    // pointPixels on screen as points in a second, and the outlines of sleeping bodies and the
+    // selection in a third. Bodies are placed between their last two steps by interpolation, see
+    // simulation::advance, and polygons take their outlines from the step's geometry cache.
+    void draw(sf::RenderWindow& window, const world& world, const geometryCache& geometry,
+              const std::vector<uint32_t>& candidates, float interpolation, threadPool& pool, bool hasSelection,
+              uint32_t selected);
+
+private:
+    void submit(sf::RenderWindow& window, const std::vector<vertex>& vertices, sf::PrimitiveType type);
+
+    static constexpr float pointPixels = 2.f;
+    static constexpr rgba sleepingColor = {128, 128, 160};
+
+    drawBatch m_bodies;
+    drawBatch m_outlines;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef PHYSIM_SCENEWRITER_H
+#define PHYSIM_SCENEWRITER_H
+
+#include "common.h"
+#include "world.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+namespace kq
+{
+
+enum class fileFormat
+{
+    Unknown,
+    Csv,
+    Snapshot
+};
+
+// A copy of the saved fields of every body, so a scene can be written while the world moves on.
+struct bodyColumns
+{
+    std::vector<vector2f> positions;
+    std::vector<vector2f> velocities;
+    std::vector<float> masses;
+    std::vector<objectType> types;
+    std::vector<vector2f> extents;
+    std::vector<rgba> colors;
+    // One per convex body, in body order.
+    std::vector<polygon> polygons;
+    vector2f worldSize;
+
+    void capture(const world& world);
+    uint32_t size() const;
+};
+
+// Writes scenes on a background thread. start only copies the bodies, formatting and writing
+// the file happen on the writer's thread while the simulation keeps running.
+class sceneWriter
+{
+public:
+    sceneWriter();
+    ~sceneWriter();
+
+    sceneWriter(const sceneWriter&) = delete;
+    sceneWriter& operator=(const sceneWriter&) = delete;
+
+    // False if a write is still running.
+    bool start(const world& world, const std::string& filename, fileFormat format);
+    void wait();
+
+    bool isBusy() const;
+    // Fraction of the bodies written so far by the running or the last write.
+    float getProgress() const;
+    // Only meaningful once the write is no longer busy.
+    bool hasFailed() const;
+    const std::string& getFilename() const;
+
+    // The formats themselves, also used by fileManager's blocking saves. progress, if given,
+    // receives the number of bodies written so far.
+    static bool writeCsv(const std::string& filename, const bodyColumns& bodies, std::atomic<uint32_t>* progress);
+    static bool writeSnapshot(const std::string& filename, const bodyColumns& bodies, std::atomic<uint32_t>* progress);
+
+private:
+    std::thread m_thread;
+    bodyColumns m_bodies;
+    std::string m_filename;
+    fileFormat m_format;
+    std::atomic<bool> m_busy;
+    std::atomic<bool> m_failed;
+    std::atomic<uint32_t> m_written;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef PHYSIM_SIMULATION_H
+#define PHYSIM_SIMULATION_H
+
+#include "common.h"
+#include "types.h"
+#include "collider.h"
+#include "geometryCache.h"
+#include "fileManager.h"
+#include "threadPool.h"
+#include "contactSolver.h"
+#include "islandManager.h"
+#include "continuousCollider.h"
+#include "objectPool.h"
+#include "profiler.h"
+#include <array>
+
+namespace kq
+{
+
+// The simulation core: bodies, collision, integration and file I/O, with no window or UI.
+// The GUI front end (physim) and the headless tool both drive one of these.
+class simulation
+{
+public:
+    // The phases of a step, in the order step runs them.
+    static constexpr std::array<profilePhase, 7> stepPhases = {profilePhase::Integrate, profilePhase::Geometry,
+        profilePhase::Broadphase, profilePhase::TimeOfImpact, profilePhase::Narrowphase, profilePhase::Resolve,
+        profilePhase::Islands};
+
+    simulation();
+    ~simulation();
+
+    simulation(const simulation&) = delete;
+    simulation& operator=(const simulation&) = delete;
+
+    // Banks frameTime and runs as many fixed steps as it covers, see m_stepSize.
+    void advance(float frameTime);
+    void step(float deltaTime);
+    // One phase of a step, untimed, so the bench times exactly what step does.
+    void runPhase(profilePhase phase, float deltaTime);
+    // Drops the banked time while paused so resuming does not jump ahead.
+    void hold();
+
+    const std::vector<physicalObject*>& getEntities() const;
+    std::vector<physicalObject*>& getEntities();
+    world& getWorld();
+    const world& getWorld() const;
+    fileManager& getFileManager();
+    collider& getCollider();
+    // Up to date with the world's bodies; positions are those of the last step, so readers that
+    // draw between steps offset the outlines, see drawBatch.
+    const geometryCache& getGeometry();
+    // Places every body again, done by step after integration.
+    void updateGeometry();
+    continuousCollider& getContinuousCollider();
+    threadPool& getThreadPool();
+    contactSolver& getSolver();
+    islandManager& getIslands();
+    profiler& getProfiler();
+    float& getStepSize();
+    int& getMaxSubsteps();
+    uint32_t getStepCount() const;
+    // Fraction of a step left over in the accumulator, used to draw bodies between steps.
+    float getInterpolation() const;
+
+    // Removing a body moves the last one into its index; handles stay valid, indices do not.
+    bool removeObject(bodyHandle handle);
+    void clearEntities();
+    // Pushes every body in a random direction, waking them all.
+    void Impulse();
+    // Creates the objects for bodies added straight to the world from first onwards.
+    void createEntities(uint32_t first);
+    physicalObject* createObject(objectType type, vector2f position, vector2f velocity, rgba color, float mass,
+                                 float radius, vector2f size);
+    // A convex body, see polygon::hull and polygon::regular.
+    physicalObject* createObject(vector2f position, vector2f velocity, rgba color, float mass, const polygon& shape);
+
+private:
+    world m_world;
+    objectPool m_pool;
+    // m_entities[i] views the body at index i of the world.
+    std::vector<physicalObject*> m_entities;
+    fileManager m_fileManager;
+    geometryCache m_geometry;
+    collider m_collider;
+    continuousCollider m_continuous;
+    threadPool m_threadPool;
+    contactSolver m_solver;
+    islandManager m_islands;
+    profiler m_profiler;
+
+    // The simulation advances in fixed steps of m_stepSize; frame time is banked in the accumulator.
+    float m_stepSize;
+    int m_maxSubsteps;
+    float m_accumulator;
+    uint32_t m_stepCount;
+    float m_interpolation;
+};
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef PHYSIM_SIMULATIONTHREAD_H
+#define PHYSIM_SIMULATIONTHREAD_H
+
+#include "common.h"
+#include "simulation.h"
+#include "tripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace kq
+{
+
+// The simulation's tunables, as the UI shows them.
+struct simulationSettings
+{
+    float stepSize = 0.f;
+    int maxSubsteps = 0;
+    uint32_t threads = 0;
+    broadphaseType broadphase = broadphaseType::BruteForce;
+    float cellSize = 0.f;
+    float treeMargin = 0.f;
+    bool batchedCircles = false;
+    int solverIterations = 0;
+    bool warmStarting = false;
+    bool continuous = false;
+    bool sleeping = false;
+    float sleepSpeed = 0.f;
+    float sleepTime = 0.f;
+    float gravity = 0.f;
+    float airResistance = 0.f;
+    float timeAcceleration = 1.f;
+};
+
+// A copy of everything the window and the UI read, taken after the simulation advanced or was
+// edited.
+struct simulationState
+{
+    using clock = std::chrono::steady_clock;
+
+    world bodies;
+    geometryCache geometry;
+    // Indices into bodies.
+    std::vector<contact> contacts;
+    // The bodies around the view, in index order, see simulationThread::setView.
+    std::vector<uint32_t> visible;
+    simulationSettings settings;
+
+    // Of the last advance.
+    uint32_t stepCount = 0;
+    uint32_t pairCount = 0;
+    uint32_t colorCount = 0;
+    uint32_t manifoldCount = 0;
+    int32_t treeHeight = 0;
+    uint32_t fastCount = 0;
+    uint32_t impactCount = 0;
+    uint32_t sleepingCount = 0;
+
+    // Of the simulation when the state was taken, see simulation::getInterpolation.
+    float interpolation = 1.f;
+    // Wall-clock seconds per step at the time acceleration then.
+    float stepDuration = 0.f;
+    clock::time_point published;
+    bool playing = false;
+
+    // Where between their last two steps to draw the bodies at now. The interpolation keeps
+    // running from the moment the state was taken, so drawing stays smooth between publishes.
+    float getInterpolation(clock::time_point now) const;
+};
+
+// Runs a simulation on its own thread, stepping on its own clock, and publishes its state
+// whenever it advanced or was edited. Once started, the thread owns the simulation: the window
+// and the UI read the latest published state without locking and change the simulation by
+// posting commands, which the thread runs between advances. Neither side ever waits for a step.
+class simulationThread
+{
+public:
+    using command = std::function<void(simulation&)>;
+
+    simulationThread(simulation& simulation);
+    ~simulationThread();
+
+    simulationThread(const simulationThread&) = delete;
+    simulationThread& operator=(const simulationThread&) = delete;
+
+    void start();
+    void stop();
+
+    // Runs command on the simulation thread before its next advance, in the order posted.
+    void post(command command);
+    void setPlaying(bool playing);
+    // The region the window shows. States list the bodies in a margin of half the view around
+    // it, found through the collider's tree, so the window only walks what it can draw. A view
+    // that stays well inside the listed region does not publish again.
+    void setView(const AABB& view);
+    // The latest published state, valid until the next call. Only one thread may read states.
+    const simulationState& getState();
+
+private:
+    void run();
+    void publish(simulationState::clock::time_point now, bool playing, const AABB& region);
+
+    simulation& m_simulation;
+    std::thread m_thread;
+    // Guards the fields below it; the simulation itself is only touched by the thread.
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::vector<command> m_commands;
+    bool m_running;
+    bool m_playing;
+    // The view with its margin, as the last published state listed it.
+    AABB m_region;
+    bool m_viewChanged;
+    tripleBuffer<simulationState> m_states;
+};
+
+} // namespace kq
+
+#endif
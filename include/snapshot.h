@@ -0,0 +1,63 @@
+#ifndef PHYSIM_SNAPSHOT_H
+#define PHYSIM_SNAPSHOT_H
+
+#include "common.h"
+#include "polygon.h"
+
+namespace kq
+{
+
+// On-disk layout of a binary scene snapshot. A file is a header, a table of column entries and
+// the columns themselves, one array per body field in the same layout as world's storage, each
+// starting on a multiple of alignment. Loading maps the file and copies every column straight
+// into the world. Readers skip columns they do not know, so later versions can add columns
+// without breaking older files.
+namespace snapshot
+{
+
+constexpr char magic[8] = {'P', 'H', 'Y', 'S', 'I', 'M', 'S', 'N'};
+// Version 2 added the polygons of convex bodies.
+constexpr uint32_t version = 2;
+// Written as a native uint32_t; a reader on a machine of the other byte order sees it reversed.
+constexpr uint32_t byteOrder = 0x01020304;
+constexpr uint32_t alignment = 64;
+
+enum class column : uint32_t
+{
+    Positions = 0,  // vector2f
+    Velocities,     // vector2f
+    Masses,         // float
+    Types,          // objectType
+    Extents,        // vector2f, see world
+    Colors,         // rgba
+    Polygons,       // polygon, one per convex body in body order
+    Count
+};
+
+struct header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t bodyCount;
+    vector2f worldSize;
+    uint32_t columnCount;
+    uint32_t reserved;
+};
+
+struct columnEntry
+{
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+};
+
+static_assert(sizeof(header) == 40, "snapshot header layout changed");
+static_assert(sizeof(columnEntry) == 16, "snapshot column entry layout changed");
+static_assert(sizeof(polygon) == 132, "snapshot polygon layout changed");
+
+} // namespace snapshot
+
+} // namespace kq
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef PHYSIM_THREADPOOL_H
+#define PHYSIM_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kq
+{
+
+// Persistent workers for data parallel loops. The calling thread takes part in every loop,
+// so a pool of one thread has no workers and runs everything inline.
+class threadPool
+{
+public:
+    threadPool(uint32_t threadCount);
+    ~threadPool();
+
+    threadPool(const threadPool&) = delete;
+    threadPool& operator=(const threadPool&) = delete;
+
+    void setThreadCount(uint32_t threadCount);
+    uint32_t getThreadCount() const;
+
+    // Splits [0, count) into chunks of at least minChunk items and calls job(begin, end) for
+    // each of them across the pool. Returns once every chunk is done.
+    void parallelFor(uint32_t count, uint32_t minChunk, const std::function<void(uint32_t, uint32_t)>& job);
+
+    static uint32_t getHardwareThreads();
+
+private:
+    void start(uint32_t threadCount);
+    void stop();
+    // seen is the generation at start, so a loop published before the worker runs is not missed.
+    void workerLoop(uint64_t seen);
+    void runChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop;
+    uint64_t m_generation;
+    // Workers yet to finish the current generation.
+    uint32_t m_pending;
+
+    const std::function<void(uint32_t, uint32_t)>* m_job;
+    uint32_t m_count;
+    uint32_t m_chunkSize;
+    uint32_t m_chunkCount;
+    std::atomic<uint32_t> m_nextChunk;
+};
+
+} // namespace kq
+
+#endif
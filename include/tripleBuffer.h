@@ -0,0 +1,60 @@
+#ifndef PHYSIM_TRIPLEBUFFER_H
+#define PHYSIM_TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace kq
+{
+
+// Hands values from one writer thread to one reader thread without locking. The writer fills
+// the back slot and publishes it, the reader takes the latest published slot as its front.
+// Publishing swaps the back slot with the middle one and taking swaps the front with it, so
+// neither side ever waits and the slot the reader holds is never written.
+template<typename T>
+class tripleBuffer
+{
+public:
+    tripleBuffer()
+        : m_slots(), m_back(0), m_middle(1), m_front(2)
+    {
+
+    }
+
+    tripleBuffer(const tripleBuffer&) = delete;
+    tripleBuffer& operator=(const tripleBuffer&) = delete;
+
+    // Writer side.
+    T& getBack() { return m_slots[m_back]; }
+
+    void publish()
+    {
+        m_back = m_middle.exchange(m_back | fresh, std::memory_order_acq_rel) & indexMask;
+    }
+
+    // Reader side: moves to the latest published value, false if there was none newer.
+    bool update()
+    {
+        if(!(m_middle.load(std::memory_order_relaxed) & fresh))
+            return false;
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    const T& getFront() const { return m_slots[m_front]; }
+
+private:
+    // Set on the middle slot by publish, cleared by update.
+    static constexpr uint8_t fresh = 4;
+    static constexpr uint8_t indexMask = 3;
+
+    std::array<T, 3> m_slots;
+    uint8_t m_back;
+    std::atomic<uint8_t> m_middle;
+    uint8_t m_front;
+};
+
+} // namespace kq
+
+#endif
@@ -2,6 +2,8 @@
 #define PHYSIM_TYPES_H
 
 #include "common.h"
+#include "world.h"
+#include "narrowphase.h"
 
 namespace kq
 {
@@ -12,221 +14,169 @@ class Circle;
 class Square;
 class Triangle;
 class Rectangle;
+class Convex;
 
 class physicalObjectArgs 
 {
 public:
-    sf::Vector2f position;
-    sf::Vector2f velocity;
-    sf::Color color;
+    vector2f position;
+    vector2f velocity;
+    rgba color;
     float mass;
     objectType type;
     float angularVelocity;
     float orientation;
 
-    physicalObjectArgs(const sf::Vector2f& position, const sf::Vector2f& velocity,
-                       const sf::Color& color, float mass, objectType type);
+    physicalObjectArgs(const vector2f& position, const vector2f& velocity,
+                       const rgba& color, float mass, objectType type);
 };
 
 class physicalObject 
 {
 public:
 
-    physicalObject(physicalObjectArgs&& args);
+    // Adds the body to the world; the object itself is only a view onto its slot there.
+    physicalObject(world& world, physicalObjectArgs&& args, vector2f extents);
+    physicalObject(world& world, physicalObjectArgs&& args, const polygon& shape);
+    // Views a body that is already in the world, see world::append.
+    physicalObject(world& world, uint32_t index);
+    virtual ~physicalObject() = default;
 
     // Common methods for all shapes.
-    virtual void move(const sf::Vector2f& offset, float deltaTime) = 0;
-    virtual void applyForce(const sf::Vector2f& force) = 0;
-    virtual void update(float deltaTime) = 0;
-    virtual void draw(sf::RenderWindow& window) const = 0;
     virtual objectType getType() const = 0;
-    virtual bool collidesWith(const physicalObject& other) const = 0;
 
-    sf::Vector2f& getPosition();
-    sf::Vector2f& getVelocity();
-    sf::Color& getColor();
-    float& getMass();
-    objectType& getObjectType();
+    // Dispatches on the type tags of both bodies, see narrowphase.h.
+    bool collidesWith(const physicalObject& other) const;
+
+    vector2f& getPosition();
+    vector2f& getVelocity();
+    rgba& getColor();
 
-    sf::Vector2f getPosition() const;
-    sf::Vector2f getVelocity() const;
-    sf::Color getColor() const;
+    vector2f getPosition() const;
+    vector2f getVelocity() const;
+    rgba getColor() const;
     float getMass() const;
     float getInvMass() const;
     objectType getObjectType() const;
     uint32_t getCollisions() const;
-
-    void applyGravity(float deltaTime);
-    void applyAirResistance(float deltaTime);
+    AABB getBounds() const;
+    uint32_t getIndex() const;
+    bodyHandle getHandle() const;
+    // Follows the body when the world moves it to another index, see world::remove.
+    void setIndex(uint32_t index);
+
+    void setMass(float mass);
+    void applyForce(const vector2f& force);
     virtual std::string toCSVString() const = 0;
 
     // ... other common methods ...
 
-    static float crossProduct(const sf::Vector2f& a, const sf::Vector2f& b);
-    static float dotProduct(const sf::Vector2f& a, const sf::Vector2f& b);
-    static sf::Vector2f normalize(const sf::Vector2f& vec);
-    static void resolveCollision(physicalObject& obj1, physicalObject& obj2);
+    static float crossProduct(const vector2f& a, const vector2f& b);
+    static float dotProduct(const vector2f& a, const vector2f& b);
+    static vector2f normalize(const vector2f& vec);
     static float restitution;
-    static bool m_outline;
     static float m_gravity;
     static float m_airResistance;
     static float m_timeAcceleration;
 
     
 protected:
-    sf::Vector2f m_position;
-    sf::Vector2f m_velocity;
-    sf::Color m_color;
-    float m_mass;
-    objectType m_type;
-    uint32_t m_collisions;
-    // ... other common attributes ...
+    vector2f getExtents() const;
+
+    world* m_world;
+    uint32_t m_index;
 };
 
 
 class Circle : public physicalObject 
 {
 public:
-    Circle(physicalObjectArgs&& args, float radius);
-
-    void move(const sf::Vector2f& offset, float deltaTime) override;
-
-    void applyForce(const sf::Vector2f& force) override;
-
-    void update(float deltaTime) override;
-
-    void draw(sf::RenderWindow& window) const override;
+    Circle(world& world, physicalObjectArgs&& args, float radius);
+    Circle(world& world, uint32_t index);
 
     objectType getType() const override;
 
-    bool collidesWith(const physicalObject& other) const override;
-
-    bool collidesWith(const Circle& other) const;
-
-    bool collidesWith(const Square& other) const;
-
-    bool collidesWith(const Triangle& other) const;
+    float getRadius() const;
 
-    bool collidesWith(const Rectangle& other) const;
+    bool containsPoint(vector2f point) const;
 
-    bool containsPoint(sf::Vector2f point) const;
-
-    std::string Circle::toCSVString() const override;
-
-private:
-    float m_radius;
+    std::string toCSVString() const override;
 };
 
 class Square : public physicalObject 
 {
 public:
-    Square(physicalObjectArgs&& args, float sideLength);
-
-    void move(const sf::Vector2f& offset, float deltaTime) override;
-
-    void applyForce(const sf::Vector2f& force) override;
-
-    void update(float deltaTime) override;
-
-    void draw(sf::RenderWindow& window) const override;
+    Square(world& world, physicalObjectArgs&& args, float sideLength);
+    Square(world& world, uint32_t index);
 
     objectType getType() const override;
 
-    bool collidesWith(const physicalObject& other) const;
-
-    bool collidesWith(const Circle& other) const;
-
-    bool collidesWith(const Square& other) const;
-
-    bool collidesWith(const Triangle& other) const;
-
-    bool collidesWith(const Rectangle& other) const;
-
     float getSideLength() const;
 
-    std::array<sf::Vector2f, 4> getVertices() const; 
+    std::array<vector2f, 4> getVertices() const; 
 
-    bool containsPoint(sf::Vector2f point) const;
+    // Local-space outline for the polygon narrowphase.
+    polygon getPolygon() const;
 
-    std::string toCSVString() const override;
+    bool containsPoint(vector2f point) const;
 
-private:
-    float m_sideLength;
+    std::string toCSVString() const override;
 };
 
 class Triangle : public physicalObject {
 public:
-    Triangle(physicalObjectArgs&& args, float sideLength);
-
-    void move(const sf::Vector2f& offset, float deltaTime) override;
-
-    void applyForce(const sf::Vector2f& force) override;
-
-    void update(float deltaTime) override;
-
-    void draw(sf::RenderWindow& window) const override;
+    Triangle(world& world, physicalObjectArgs&& args, float sideLength);
+    Triangle(world& world, uint32_t index);
 
     objectType getType() const override;
 
-    bool collidesWith(const physicalObject& other) const;
-
-    bool collidesWith(const Circle& other) const;
-
-    bool collidesWith(const Square& other) const;
-
-    bool collidesWith(const Triangle& other) const;
-
-    bool collidesWith(const Rectangle& other) const;
-
     float getSideLength() const;
 
-    std::array<sf::Vector2f, 3> Triangle::getVertices() const;
+    std::array<vector2f, 3> getVertices() const;
 
-    bool containsPoint(sf::Vector2f point) const;
+    polygon getPolygon() const;
 
-    std::string toCSVString() const override;
+    bool containsPoint(vector2f point) const;
 
-private:
-    float m_sideLength;
+    std::string toCSVString() const override;
 };
 
 class Rectangle : public physicalObject {
 public:
-    Rectangle(physicalObjectArgs&& args, float width, float height);
-
-    void move(const sf::Vector2f& offset, float deltaTime) override;
-
-    void applyForce(const sf::Vector2f& force) override;
-
-    void update(float deltaTime) override;
-
-    void draw(sf::RenderWindow& window) const override;
+    Rectangle(world& world, physicalObjectArgs&& args, float width, float height);
+    Rectangle(world& world, uint32_t index);
 
     objectType getType() const override;
 
-    bool collidesWith(const physicalObject& other) const;
+    float getWidth() const;
 
-    bool collidesWith(const Circle& other) const;
+    float getHeight() const;
 
-    bool collidesWith(const Square& other) const;
+    bool containsPoint(vector2f point) const;
 
-    bool collidesWith(const Triangle& other) const;
+    std::array<vector2f, 4> getVertices() const;
 
-    bool collidesWith(const Rectangle& other) const;
+    polygon getPolygon() const;
 
-    float getWidth() const;
+    std::string toCSVString() const override;
+};
 
-    float getHeight() const;
+// Any convex polygon up to polygon::maxVertices, kept in local space with its edge normals.
+// Collides through the same polygon narrowphase as the boxes and triangles.
+class Convex : public physicalObject {
+public:
+    // The shape is placed with its centroid on the position, see polygon::hull.
+    Convex(world& world, physicalObjectArgs&& args, const polygon& shape);
+    Convex(world& world, uint32_t index);
 
-    bool containsPoint(sf::Vector2f point) const;
+    objectType getType() const override;
 
-    std::array<sf::Vector2f, 4> getVertices() const;
+    const polygon& getPolygon() const;
 
-    std::string toCSVString() const override;
+    // World-space corners.
+    std::vector<vector2f> getVertices() const;
 
-private:
-    float m_width;
-    float m_height;
+    std::string toCSVString() const override;
 };
 
 
@@ -3,7 +3,13 @@
 
 #include "common.h"
 #include "types.h"
+#include "simulationThread.h"
+#include "sceneWriter.h"
+#include "imgui.h"
 #include <array>
+#include <atomic>
+#include <cfloat>
+#include <memory>
 
 namespace kq
 {
@@ -26,14 +32,20 @@ public:
     objectType getType();
     float getRadius();
     float getRotation();
-    sf::Vector2f getSize();
-    sf::Vector2f getVelocity();
+    vector2f getSize();
+    int getSides();
+    vector2f getVelocity();
+    // The selection is kept as a handle, so it is dropped rather than moved to another body when
+    // its body is removed or the scene is cleared.
     bool isSelected();
     uint32_t getSelected();
+    bodyHandle getSelectedHandle() const;
+    void select(uint32_t index);
+    void select(bodyHandle handle);
     float getMass();
     
-    std::string getShapeName(objectType type);
-    void getColorBox(sf::Color color);
+    static const char* getShapeName(objectType type);
+    void getColorBox(rgba color);
     std::array<float, 4> getColor() const;
     
 
@@ -44,23 +56,65 @@ private:
     void objectPanel();
     void importPanel();
     void exportPanel();
+    void profilerPanel();
+    void updateListRows();
+    // Runs command on the simulation thread, see simulationThread::post.
+    void post(simulationThread::command command);
+
+    // An import running on the simulation thread; done is set once the rest is filled in.
+    struct importStatus
+    {
+        std::atomic<bool> done{false};
+        bool loaded = false;
+        std::vector<fileManager::parseError> errors;
+    };
+
+    // What the list panel shows and in which order.
+    struct listFilter
+    {
+        int type = 0;   // 0 for every type, otherwise objectType + 1
+        float minMass = 0.f;
+        float maxMass = FLT_MAX;   // FLT_MAX for no limit
+        int sortColumn = 0;
+        bool ascending = true;
+
+        bool operator==(const listFilter& other) const
+        {
+            return type == other.type && minMass == other.minMass && maxMass == other.maxMass &&
+                   sortColumn == other.sortColumn && ascending == other.ascending;
+        }
+    };
 
     physim* m_parent;
     bool m_toggle;
     objectType m_type;
     float m_radius;
     float m_rotation;
-    sf::Vector2f m_size;
-    sf::Vector2f m_velocity;
+    vector2f m_size;
+    int m_sides;
+    vector2f m_velocity;
     bool m_play;
     std::array<float, 4> m_color;
-    uint32_t m_selected;
-    bool m_showSelected;
+    bodyHandle m_selected;
     float m_mass;
     bool m_exportMenu;
     bool m_importMenu;
+    listFilter m_listFilter;
+    // The list panel's rows, filtered and sorted; rebuilt only when the bodies or the filter change.
+    listFilter m_listRowsFilter;
+    std::vector<uint32_t> m_listRows;
+    uint64_t m_listRowsRevision;
+    // Mass of the heaviest body at the last rebuild, the top of the mass filter's range.
+    float m_heaviest;
+    std::shared_ptr<importStatus> m_import;
+    // Whether the finished import was already looked at, so it closes the menu only once.
+    bool m_importShown;
+    // Exports write the published state, from the UI's side.
+    sceneWriter m_writer;
     
     const char* m_types[5] = { "Circle", "Square", "Rectangle", "Triangle", "Convex" };
+    const char* m_listTypes[6] = { "All types", "Circle", "Square", "Rectangle", "Triangle", "Convex" };
+    const char* m_broadphases[3] = { "Brute force", "Uniform grid", "AABB tree" };
 
 };
 
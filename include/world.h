@@ -0,0 +1,148 @@
+#ifndef PHYSIM_WORLD_H
+#define PHYSIM_WORLD_H
+
+#include "common.h"
+#include "polygon.h"
+
+namespace kq
+{
+
+class physicalObjectArgs;
+
+// Data that is only read by the UI, rendering and file I/O.
+struct bodyInfo
+{
+    rgba color;
+    uint32_t collisions;
+};
+
+// Stable reference to a body. Indices change when bodies are removed, handles do not; a handle
+// to a removed body is recognised by its generation and never resolves to another body.
+struct bodyHandle
+{
+    static constexpr uint32_t invalidSlot = UINT32_MAX;
+
+    uint32_t slot = invalidSlot;
+    uint32_t generation = 0;
+
+    bool operator==(const bodyHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const bodyHandle& other) const { return !(*this == other); }
+};
+
+// Structure-of-arrays storage for every body. Integration and collision only walk the hot
+// per-field arrays; color and statistics live in a separate array so they stay out of the cache.
+// Extents hold the shape dimensions: (radius, radius) for circles, (side, side) for squares and
+// triangles, (width, height) for rectangles and the size of the bounds for convex polygons, whose
+// vertices live in a separate pool.
+class world
+{
+public:
+    world();
+
+    uint32_t add(const physicalObjectArgs& args, vector2f extents);
+    uint32_t add(const physicalObjectArgs& args, const polygon& shape);
+    // Appends count bodies from one array per field, used by bulk loads. Returns the first index.
+    // polygons holds one shape per convex body, in the order they appear.
+    uint32_t append(uint32_t count, const vector2f* positions, const vector2f* velocities, const float* masses,
+                    const objectType* types, const vector2f* extents, const rgba* colors,
+                    const polygon* polygons = nullptr);
+    // Moves the last body into the freed index, so the arrays stay dense.
+    void remove(uint32_t index);
+    void clear();
+    uint32_t size() const;
+
+    // Changes whenever bodies are added or removed or a mass changes, so caches built from the
+    // body set know when to rebuild.
+    uint64_t getRevision() const;
+
+    bodyHandle getHandle(uint32_t index) const;
+    // The body's current index, or invalidIndex once it has been removed.
+    uint32_t getIndex(bodyHandle handle) const;
+    static constexpr uint32_t invalidIndex = UINT32_MAX;
+
+    // Bodies are independent during integration, so disjoint ranges may run concurrently.
+    void integrate(float deltaTime);
+    void integrate(float deltaTime, uint32_t begin, uint32_t end);
+
+    // Bodies bounce off the edges of [0, size]. The world is independent of the window, the
+    // front end looks at it through a camera.
+    vector2f getSize() const;
+    void setSize(vector2f size);
+
+    AABB getBounds(uint32_t index) const;
+    // Covers the body at the previous step and at the current one.
+    AABB getSweptBounds(uint32_t index) const;
+    // Position between the last two steps, alpha = 0 at the previous step and 1 at the current one.
+    vector2f getInterpolatedPosition(uint32_t index, float alpha) const;
+    void setMass(uint32_t index, float mass);
+    // Only for convex bodies; the other shapes are built from their extents, see polygon.
+    const polygon& getPolygon(uint32_t index) const;
+
+    // Sleeping bodies are skipped by integration and by pair generation between two sleepers.
+    // Putting a body to sleep stops it; waking it restarts its sleep timer.
+    bool isAsleep(uint32_t index) const;
+    void sleep(uint32_t index);
+    void wake(uint32_t index);
+    void wakeAll();
+
+    std::vector<vector2f>& getPositions();
+    std::vector<vector2f>& getVelocities();
+    std::vector<bodyInfo>& getInfo();
+    // Seconds each body has spent below the sleep speed.
+    std::vector<float>& getSleepTimers();
+
+    const std::vector<vector2f>& getPositions() const;
+    const std::vector<vector2f>& getPreviousPositions() const;
+    const std::vector<vector2f>& getVelocities() const;
+    const std::vector<float>& getMasses() const;
+    const std::vector<float>& getInvMasses() const;
+    const std::vector<vector2f>& getExtents() const;
+    const std::vector<AABB>& getLocalBounds() const;
+    const std::vector<objectType>& getTypes() const;
+    const std::vector<bodyInfo>& getInfo() const;
+    const std::vector<uint8_t>& getAsleep() const;
+
+    static AABB localBounds(objectType type, vector2f extents);
+
+private:
+    // Slot map behind the handles: a slot holds the index of its body while it is alive and is
+    // recycled with a new generation once the body is gone.
+    struct slot
+    {
+        uint32_t index;
+        uint32_t generation;
+    };
+
+    void addSlot(uint32_t index);
+    uint32_t addPolygon(const polygon& shape);
+
+    std::vector<vector2f> m_positions;
+    std::vector<vector2f> m_previousPositions;
+    std::vector<vector2f> m_velocities;
+    std::vector<float> m_masses;
+    std::vector<float> m_invMasses;
+    std::vector<vector2f> m_extents;
+    std::vector<AABB> m_localBounds;
+    std::vector<objectType> m_types;
+    std::vector<uint8_t> m_asleep;
+    std::vector<float> m_sleepTimers;
+    // Index into m_polygons for convex bodies, invalidIndex for the others.
+    std::vector<uint32_t> m_shapes;
+
+    std::vector<bodyInfo> m_info;
+
+    std::vector<polygon> m_polygons;
+    std::vector<uint32_t> m_freePolygons;
+
+    std::vector<slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    // Slot of the body at each index.
+    std::vector<uint32_t> m_bodySlots;
+
+    vector2f m_size;
+    uint64_t m_revision;
+};
+
+} // namespace kq
+
+#endif
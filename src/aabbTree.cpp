@@ -0,0 +1,343 @@
+#include "aabbTree.h"
+#include <algorithm>
+
+namespace kq
+{
+
+aabbTree::aabbTree(float margin)
+    : m_nodes(), m_root(nullNode), m_freeList(nullNode), m_margin(margin)
+{
+
+}
+
+int32_t aabbTree::createProxy(const AABB& bounds, uint32_t userData)
+{
+    int32_t proxy = allocateNode();
+    node& leaf = m_nodes[proxy];
+    leaf.bounds = {bounds.min - vector2f{m_margin, m_margin}, bounds.max + vector2f{m_margin, m_margin}};
+    leaf.userData = userData;
+    leaf.height = 0;
+    insertLeaf(proxy);
+    return proxy;
+}
+
+void aabbTree::destroyProxy(int32_t proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+}
+
+bool aabbTree::moveProxy(int32_t proxy, const AABB& bounds, vector2f displacement)
+{
+    const AABB& fat = m_nodes[proxy].bounds;
+    if(fat.min.x <= bounds.min.x && fat.min.y <= bounds.min.y &&
+       fat.max.x >= bounds.max.x && fat.max.y >= bounds.max.y)
+    {
+        return false;
+    }
+
+    removeLeaf(proxy);
+
+    AABB fattened = {bounds.min - vector2f{m_margin, m_margin}, bounds.max + vector2f{m_margin, m_margin}};
+    if(displacement.x < 0.f)
+        fattened.min.x += displacement.x;
+    else
+        fattened.max.x += displacement.x;
+    if(displacement.y < 0.f)
+        fattened.min.y += displacement.y;
+    else
+        fattened.max.y += displacement.y;
+    m_nodes[proxy].bounds = fattened;
+
+    insertLeaf(proxy);
+    return true;
+}
+
+void aabbTree::clear()
+{
+    m_nodes.clear();
+    m_root = nullNode;
+    m_freeList = nullNode;
+}
+
+const AABB& aabbTree::getFatBounds(int32_t proxy) const { return m_nodes[proxy].bounds; }
+
+uint32_t aabbTree::getUserData(int32_t proxy) const { return m_nodes[proxy].userData; }
+
+int32_t aabbTree::getHeight() const { return m_root == nullNode ? 0 : m_nodes[m_root].height; }
+
+float aabbTree::getMargin() const { return m_margin; }
+
+void aabbTree::setMargin(float margin) { m_margin = std::max(margin, 0.f); }
+
+void aabbTree::findPairs(const std::vector<AABB>& bounds, const std::vector<uint8_t>& asleep, std::vector<collisionPair>& pairs) const
+{
+    for(uint32_t i = 0; i < bounds.size(); ++i)
+    {
+        if(asleep[i])
+            continue;
+        const AABB& boundsA = bounds[i];
+        query(boundsA, [&](uint32_t other)
+        {
+            // A sleeping body is never the querying side, so its pairs with awake bodies of any
+            // index are reported from here.
+            bool report = asleep[other] ? true : other > i;
+            if(report && boundsA.overlaps(bounds[other]))
+            {
+                pairs.push_back({std::min(i, other), std::max(i, other)});
+            }
+            return true;
+        });
+    }
+}
+
+int32_t aabbTree::allocateNode()
+{
+    int32_t index;
+    if(m_freeList != nullNode)
+    {
+        index = m_freeList;
+        m_freeList = m_nodes[index].parent;
+    }
+    else
+    {
+        index = static_cast<int32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    node& allocated = m_nodes[index];
+    allocated.parent = nullNode;
+    allocated.child1 = nullNode;
+    allocated.child2 = nullNode;
+    allocated.height = 0;
+    allocated.userData = 0;
+    return index;
+}
+
+void aabbTree::freeNode(int32_t index)
+{
+    m_nodes[index].parent = m_freeList;
+    m_nodes[index].height = -1;
+    m_freeList = index;
+}
+
+void aabbTree::insertLeaf(int32_t leaf)
+{
+    if(m_root == nullNode)
+    {
+        m_root = leaf;
+        m_nodes[leaf].parent = nullNode;
+        return;
+    }
+
+    // Walk down towards the sibling that grows the total perimeter the least.
+    AABB leafBounds = m_nodes[leaf].bounds;
+    int32_t index = m_root;
+    while(!m_nodes[index].isLeaf())
+    {
+        const node& current = m_nodes[index];
+        float area = perimeter(current.bounds);
+        float combinedArea = perimeter(combine(current.bounds, leafBounds));
+
+        // Cost of pairing the leaf with this node, and the cost pushed down to the children.
+        float cost = 2.f * combinedArea;
+        float inheritanceCost = 2.f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child)
+        {
+            const node& candidate = m_nodes[child];
+            float grown = perimeter(combine(leafBounds, candidate.bounds));
+            if(candidate.isLeaf())
+                return grown + inheritanceCost;
+            return grown - perimeter(candidate.bounds) + inheritanceCost;
+        };
+        float cost1 = descendCost(current.child1);
+        float cost2 = descendCost(current.child2);
+
+        if(cost < cost1 && cost < cost2)
+            break;
+        index = cost1 < cost2 ? current.child1 : current.child2;
+    }
+
+    int32_t sibling = index;
+    int32_t oldParent = m_nodes[sibling].parent;
+    int32_t newParent = allocateNode();
+    m_nodes[newParent].parent = oldParent;
+    m_nodes[newParent].bounds = combine(leafBounds, m_nodes[sibling].bounds);
+    m_nodes[newParent].height = m_nodes[sibling].height + 1;
+    m_nodes[newParent].child1 = sibling;
+    m_nodes[newParent].child2 = leaf;
+    m_nodes[sibling].parent = newParent;
+    m_nodes[leaf].parent = newParent;
+
+    if(oldParent != nullNode)
+    {
+        if(m_nodes[oldParent].child1 == sibling)
+            m_nodes[oldParent].child1 = newParent;
+        else
+            m_nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        m_root = newParent;
+    }
+
+    refit(m_nodes[leaf].parent);
+}
+
+void aabbTree::removeLeaf(int32_t leaf)
+{
+    if(leaf == m_root)
+    {
+        m_root = nullNode;
+        return;
+    }
+
+    int32_t parent = m_nodes[leaf].parent;
+    int32_t grandParent = m_nodes[parent].parent;
+    int32_t sibling = m_nodes[parent].child1 == leaf ? m_nodes[parent].child2 : m_nodes[parent].child1;
+
+    if(grandParent != nullNode)
+    {
+        if(m_nodes[grandParent].child1 == parent)
+            m_nodes[grandParent].child1 = sibling;
+        else
+            m_nodes[grandParent].child2 = sibling;
+        m_nodes[sibling].parent = grandParent;
+        freeNode(parent);
+        refit(grandParent);
+    }
+    else
+    {
+        m_root = sibling;
+        m_nodes[sibling].parent = nullNode;
+        freeNode(parent);
+    }
+}
+
+void aabbTree::refit(int32_t index)
+{
+    while(index != nullNode)
+    {
+        index = balance(index);
+
+        node& current = m_nodes[index];
+        const node& child1 = m_nodes[current.child1];
+        const node& child2 = m_nodes[current.child2];
+        current.height = 1 + std::max(child1.height, child2.height);
+        current.bounds = combine(child1.bounds, child2.bounds);
+
+        index = current.parent;
+    }
+}
+
+// Rotates the taller grandchild up when the subtree under index is unbalanced.
+// Returns the index of the subtree's new root.
+int32_t aabbTree::balance(int32_t iA)
+{
+    node& A = m_nodes[iA];
+    if(A.isLeaf() || A.height < 2)
+        return iA;
+
+    int32_t iB = A.child1;
+    int32_t iC = A.child2;
+    node& B = m_nodes[iB];
+    node& C = m_nodes[iC];
+
+    int32_t difference = C.height - B.height;
+
+    auto replaceInParent = [&](int32_t newChild)
+    {
+        int32_t parent = m_nodes[newChild].parent;
+        if(parent == nullNode)
+            m_root = newChild;
+        else if(m_nodes[parent].child1 == iA)
+            m_nodes[parent].child1 = newChild;
+        else
+            m_nodes[parent].child2 = newChild;
+    };
+
+    if(difference > 1)
+    {
+        int32_t iF = C.child1;
+        int32_t iG = C.child2;
+        node& F = m_nodes[iF];
+        node& G = m_nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceInParent(iC);
+
+        if(F.height > G.height)
+        {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.bounds = combine(B.bounds, G.bounds);
+            C.bounds = combine(A.bounds, F.bounds);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else
+        {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.bounds = combine(B.bounds, F.bounds);
+            C.bounds = combine(A.bounds, G.bounds);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    if(difference < -1)
+    {
+        int32_t iD = B.child1;
+        int32_t iE = B.child2;
+        node& D = m_nodes[iD];
+        node& E = m_nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceInParent(iB);
+
+        if(D.height > E.height)
+        {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.bounds = combine(C.bounds, E.bounds);
+            B.bounds = combine(A.bounds, D.bounds);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else
+        {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.bounds = combine(C.bounds, D.bounds);
+            B.bounds = combine(A.bounds, E.bounds);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+AABB aabbTree::combine(const AABB& a, const AABB& b)
+{
+    return {{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y)},
+            {std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y)}};
+}
+
+float aabbTree::perimeter(const AABB& bounds)
+{
+    return 2.f * ((bounds.max.x - bounds.min.x) + (bounds.max.y - bounds.min.y));
+}
+
+} // namespace kq
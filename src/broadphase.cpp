@@ -0,0 +1,93 @@
+#include "broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kq
+{
+
+spatialGrid::spatialGrid(float cellSize)
+    : m_cellSize(), m_invCellSize(), m_entries()
+{
+    setCellSize(cellSize);
+}
+
+void spatialGrid::setCellSize(float cellSize)
+{
+    m_cellSize = std::max(cellSize, 1.f);
+    m_invCellSize = 1.f / m_cellSize;
+}
+
+float spatialGrid::getCellSize() const
+{
+    return m_cellSize;
+}
+
+int32_t spatialGrid::cellCoord(float value) const
+{
+    return static_cast<int32_t>(std::floor(value * m_invCellSize));
+}
+
+uint64_t spatialGrid::cellKey(int32_t x, int32_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void spatialGrid::findPairs(const std::vector<AABB>& bounds, const std::vector<uint8_t>& asleep, std::vector<collisionPair>& pairs)
+{
+    m_entries.clear();
+    for(uint32_t i = 0; i < bounds.size(); ++i)
+    {
+        int32_t minX = cellCoord(bounds[i].min.x);
+        int32_t minY = cellCoord(bounds[i].min.y);
+        int32_t maxX = cellCoord(bounds[i].max.x);
+        int32_t maxY = cellCoord(bounds[i].max.y);
+        for(int32_t x = minX; x <= maxX; ++x)
+        {
+            for(int32_t y = minY; y <= maxY; ++y)
+            {
+                m_entries.push_back({cellKey(x, y), i});
+            }
+        }
+    }
+
+    // Sorting by index within a cell keeps first < second for every reported pair.
+    std::sort(m_entries.begin(), m_entries.end(), [](const cellEntry& a, const cellEntry& b)
+    {
+        return a.key < b.key || (a.key == b.key && a.index < b.index);
+    });
+
+    size_t begin = 0;
+    while(begin < m_entries.size())
+    {
+        size_t end = begin + 1;
+        while(end < m_entries.size() && m_entries[end].key == m_entries[begin].key)
+            ++end;
+
+        uint64_t key = m_entries[begin].key;
+        for(size_t a = begin; a < end; ++a)
+        {
+            const AABB& boundsA = bounds[m_entries[a].index];
+            bool asleepA = asleep[m_entries[a].index] != 0;
+            for(size_t b = a + 1; b < end; ++b)
+            {
+                if(asleepA && asleep[m_entries[b].index])
+                    continue;
+                const AABB& boundsB = bounds[m_entries[b].index];
+                if(!boundsA.overlaps(boundsB))
+                    continue;
+
+                // Bodies spanning several cells meet in each of them; only the cell holding
+                // the top-left corner of their overlap reports the pair.
+                int32_t ownerX = cellCoord(std::max(boundsA.min.x, boundsB.min.x));
+                int32_t ownerY = cellCoord(std::max(boundsA.min.y, boundsB.min.y));
+                if(cellKey(ownerX, ownerY) != key)
+                    continue;
+
+                pairs.push_back({m_entries[a].index, m_entries[b].index});
+            }
+        }
+        begin = end;
+    }
+}
+
+} // namespace kq
@@ -0,0 +1,157 @@
+#include "circleKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PHYSIM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang only emit AVX2 code in functions that opt in; MSVC accepts the intrinsics anywhere.
+#if defined(PHYSIM_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PHYSIM_TARGET_AVX2 __attribute__((target("avx2")))
+#define PHYSIM_TARGET_SSE __attribute__((target("sse2")))
+#else
+#define PHYSIM_TARGET_AVX2
+#define PHYSIM_TARGET_SSE
+#endif
+
+namespace kq
+{
+
+namespace circleKernel
+{
+
+namespace
+{
+
+uint32_t laneMask(uint32_t count)
+{
+    return count >= batchSize ? (1u << batchSize) - 1 : (1u << count) - 1;
+}
+
+uint32_t testScalar(float x, float y, float radius, const float* xs, const float* ys, const float* radii, uint32_t count)
+{
+    uint32_t mask = 0;
+    for(uint32_t i = 0; i < count && i < batchSize; ++i)
+    {
+        float dx = xs[i] - x;
+        float dy = ys[i] - y;
+        float reach = radii[i] + radius;
+        if(dx * dx + dy * dy < reach * reach)
+            mask |= 1u << i;
+    }
+    return mask;
+}
+
+#ifdef PHYSIM_X86
+
+PHYSIM_TARGET_SSE
+uint32_t testSSE(float x, float y, float radius, const float* xs, const float* ys, const float* radii, uint32_t count)
+{
+    const __m128 cx = _mm_set1_ps(x);
+    const __m128 cy = _mm_set1_ps(y);
+    const __m128 cr = _mm_set1_ps(radius);
+    uint32_t mask = 0;
+    for(uint32_t offset = 0; offset < batchSize; offset += 4)
+    {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + offset), cx);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + offset), cy);
+        __m128 reach = _mm_add_ps(_mm_loadu_ps(radii + offset), cr);
+        __m128 distance = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmplt_ps(distance, _mm_mul_ps(reach, reach)))) << offset;
+    }
+    return mask & laneMask(count);
+}
+
+PHYSIM_TARGET_AVX2
+uint32_t testAVX2(float x, float y, float radius, const float* xs, const float* ys, const float* radii, uint32_t count)
+{
+    __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs), _mm256_set1_ps(x));
+    __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys), _mm256_set1_ps(y));
+    __m256 reach = _mm256_add_ps(_mm256_loadu_ps(radii), _mm256_set1_ps(radius));
+    __m256 distance = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+    __m256 hits = _mm256_cmp_ps(distance, _mm256_mul_ps(reach, reach), _CMP_LT_OQ);
+    return static_cast<uint32_t>(_mm256_movemask_ps(hits)) & laneMask(count);
+}
+
+instructionSet detect()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse2 = (info[3] & (1 << 26)) != 0;
+    // AVX state must also be enabled by the OS, which OSXSAVE and XCR0 report.
+    bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if(maxLeaf >= 7 && osAvx)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse2 = __builtin_cpu_supports("sse2");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if(avx2)
+        return instructionSet::AVX2;
+    if(sse2)
+        return instructionSet::SSE;
+    return instructionSet::Scalar;
+}
+
+#else
+
+instructionSet detect()
+{
+    return instructionSet::Scalar;
+}
+
+#endif
+
+} // namespace
+
+instructionSet getInstructionSet()
+{
+    static const instructionSet detected = detect();
+    return detected;
+}
+
+const char* getInstructionSetName(instructionSet set)
+{
+    switch(set)
+    {
+        case instructionSet::AVX2:
+            return "AVX2";
+        case instructionSet::SSE:
+            return "SSE";
+        default:
+            return "Scalar";
+    }
+}
+
+batchFunction getBatchFunction(instructionSet set)
+{
+#ifdef PHYSIM_X86
+    if(set == instructionSet::AVX2)
+        return testAVX2;
+    if(set == instructionSet::SSE)
+        return testSSE;
+#endif
+    (void)set;
+    return testScalar;
+}
+
+uint32_t testBatch(float x, float y, float radius, const float* xs, const float* ys, const float* radii, uint32_t count)
+{
+    static const batchFunction function = getBatchFunction(getInstructionSet());
+    return function(x, y, radius, xs, ys, radii, count);
+}
+
+} // namespace circleKernel
+
+} // namespace kq
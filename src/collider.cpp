@@ -0,0 +1,207 @@
+#include "collider.h"
+#include "types.h"
+
+namespace kq
+{
+
+collider::collider()
+    : m_broadphase(broadphaseType::Grid), m_grid(200.f), m_tree(10.f), m_proxies(), m_proxyHandles(), m_bounds(), m_queryBounds(), m_pairs(), m_contacts(),
+    m_simplices(), m_batchedCircles(true), m_circleBatch()
+{
+    m_contacts.reserve(1024);
+}
+
+broadphaseType& collider::getBroadphase() { return m_broadphase; }
+
+float collider::getCellSize() const { return m_grid.getCellSize(); }
+
+void collider::setCellSize(float cellSize) { m_grid.setCellSize(cellSize); }
+
+float collider::getTreeMargin() const { return m_tree.getMargin(); }
+
+void collider::setTreeMargin(float margin) { m_tree.setMargin(margin); }
+
+int32_t collider::getTreeHeight() const { return m_tree.getHeight(); }
+
+bool& collider::getBatchedCircles() { return m_batchedCircles; }
+
+const std::vector<collisionPair>& collider::findPairs(const world& world, const geometryCache& geometry)
+{
+    m_pairs.clear();
+    if(m_broadphase == broadphaseType::Tree)
+    {
+        updateTree(world, geometry.getSweptBounds());
+        m_tree.findPairs(m_bounds, world.getAsleep(), m_pairs);
+    }
+    else
+    {
+        m_grid.findPairs(geometry.getSweptBounds(), world.getAsleep(), m_pairs);
+    }
+    return m_pairs;
+}
+
+const std::vector<collisionPair>& collider::getPairs() const { return m_pairs; }
+
+const std::vector<contact>& collider::findContacts(const world& world, const geometryCache& geometry)
+{
+    m_contacts.clear();
+    if(m_broadphase == broadphaseType::BruteForce)
+    {
+        m_pairs.clear();
+        const std::vector<uint8_t>& asleep = world.getAsleep();
+        for(uint32_t i = 0; i < world.size(); ++i)
+        {
+            for(uint32_t j = i + 1; j < world.size(); ++j)
+            {
+                if(asleep[i] && asleep[j])
+                    continue;
+                testPair(world, geometry, i, j);
+            }
+        }
+    }
+    else
+    {
+        findPairs(world, geometry);
+        return testPairs(world, geometry);
+    }
+    flushCircleBatch(world);
+    m_simplices.endStep();
+    return m_contacts;
+}
+
+const std::vector<contact>& collider::testPairs(const world& world, const geometryCache& geometry)
+{
+    m_contacts.clear();
+    for(const collisionPair& pair : m_pairs)
+    {
+        testPair(world, geometry, pair.first, pair.second);
+    }
+    flushCircleBatch(world);
+    m_simplices.endStep();
+    return m_contacts;
+}
+
+const std::vector<contact>& collider::getContacts() const { return m_contacts; }
+
+const narrowphase::simplexCache& collider::getSimplexCache() const { return m_simplices; }
+
+void collider::testPair(const world& world, const geometryCache& geometry, uint32_t first, uint32_t second)
+{
+    const std::vector<objectType>& types = world.getTypes();
+    if(m_batchedCircles && types[first] == objectType::Circle && types[second] == objectType::Circle)
+    {
+        // Both broadphases and the brute-force loop emit runs of pairs sharing their first body.
+        if(m_circleBatch.count == circleKernel::batchSize || (m_circleBatch.count > 0 && m_circleBatch.first != first))
+            flushCircleBatch(world);
+
+        uint32_t lane = m_circleBatch.count++;
+        m_circleBatch.first = first;
+        m_circleBatch.seconds[lane] = second;
+        m_circleBatch.xs[lane] = world.getPositions()[second].x;
+        m_circleBatch.ys[lane] = world.getPositions()[second].y;
+        m_circleBatch.radii[lane] = world.getExtents()[second].x;
+        return;
+    }
+
+    contact result;
+    if(narrowphase::collide(world, geometry, first, second, result, &m_simplices))
+        m_contacts.push_back(result);
+}
+
+void collider::flushCircleBatch(const world& world)
+{
+    if(m_circleBatch.count == 0)
+        return;
+
+    uint32_t first = m_circleBatch.first;
+    vector2f position = world.getPositions()[first];
+    uint32_t hits = circleKernel::testBatch(position.x, position.y, world.getExtents()[first].x,
+                                            m_circleBatch.xs, m_circleBatch.ys, m_circleBatch.radii, m_circleBatch.count);
+    for(uint32_t lane = 0; hits != 0; ++lane, hits >>= 1)
+    {
+        if(hits & 1)
+        {
+            contact result;
+            narrowphase::circleContact(world, first, m_circleBatch.seconds[lane], result);
+            m_contacts.push_back(result);
+        }
+    }
+    m_circleBatch.count = 0;
+}
+
+void collider::queryPoint(const world& world, vector2f point, std::vector<uint32_t>& result)
+{
+    updateTree(world);
+    m_tree.queryPoint(point, [&](uint32_t index)
+    {
+        if(m_bounds[index].contains(point))
+            result.push_back(index);
+        return true;
+    });
+}
+
+void collider::queryRegion(const world& world, const AABB& region, std::vector<uint32_t>& result)
+{
+    updateTree(world);
+    m_tree.query(region, [&](uint32_t index)
+    {
+        if(m_bounds[index].overlaps(region))
+            result.push_back(index);
+        return true;
+    });
+}
+
+void collider::updateTree(const world& world)
+{
+    m_queryBounds.resize(world.size());
+    for(uint32_t i = 0; i < world.size(); ++i)
+    {
+        m_queryBounds[i] = world.getSweptBounds(i);
+    }
+    updateTree(world, m_queryBounds);
+}
+
+void collider::updateTree(const world& world, const std::vector<AABB>& bounds)
+{
+    // Removal moves the last body into the freed index, so only the trailing proxies go away.
+    // A proxy whose index now holds another body is reinserted: its fat bounds and the old
+    // bounds it would be displaced from belong to the body that left.
+    const uint32_t count = static_cast<uint32_t>(bounds.size());
+    if(count == 0)
+    {
+        m_tree.clear();
+        m_proxies.clear();
+        m_proxyHandles.clear();
+    }
+    while(m_proxies.size() > count)
+    {
+        m_tree.destroyProxy(m_proxies.back());
+        m_proxies.pop_back();
+        m_proxyHandles.pop_back();
+    }
+
+    m_bounds.resize(count);
+    for(uint32_t i = 0; i < m_proxies.size(); ++i)
+    {
+        bodyHandle handle = world.getHandle(i);
+        if(handle != m_proxyHandles[i])
+        {
+            m_tree.destroyProxy(m_proxies[i]);
+            m_proxies[i] = m_tree.createProxy(bounds[i], i);
+            m_proxyHandles[i] = handle;
+        }
+        else
+        {
+            m_tree.moveProxy(m_proxies[i], bounds[i], bounds[i].min - m_bounds[i].min);
+        }
+        m_bounds[i] = bounds[i];
+    }
+    for(uint32_t i = static_cast<uint32_t>(m_proxies.size()); i < count; ++i)
+    {
+        m_bounds[i] = bounds[i];
+        m_proxies.push_back(m_tree.createProxy(m_bounds[i], i));
+        m_proxyHandles.push_back(world.getHandle(i));
+    }
+}
+
+} // namespace kq
@@ -0,0 +1,204 @@
+#include "contactSolver.h"
+#include "types.h"
+#include <algorithm>
+#include <array>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace kq
+{
+
+namespace
+{
+
+uint32_t lowestSetBit(uint64_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+float dot(vector2f a, vector2f b) { return a.x * b.x + a.y * b.y; }
+
+} // namespace
+
+contactSolver::contactSolver()
+    : m_bodyColors(), m_contactColors(), m_ordered(), m_batchOffsets(maxColors + 2), m_constraints(), m_manifolds(),
+    m_colorCount(0), m_step(0), m_iterations(4), m_warmStarting(true)
+{
+
+}
+
+template<typename Function>
+void contactSolver::forEachBatch(threadPool& pool, Function&& function)
+{
+    for(uint32_t color = 0; color < maxColors; ++color)
+    {
+        uint32_t begin = m_batchOffsets[color];
+        uint32_t count = m_batchOffsets[color + 1] - begin;
+        pool.parallelFor(count, 256, [&](uint32_t first, uint32_t last)
+        {
+            for(uint32_t i = begin + first; i < begin + last; ++i)
+            {
+                function(m_constraints[i]);
+            }
+        });
+    }
+
+    for(uint32_t i = m_batchOffsets[maxColors]; i < m_batchOffsets[maxColors + 1]; ++i)
+    {
+        function(m_constraints[i]);
+    }
+}
+
+void contactSolver::solve(world& world, const std::vector<contact>& contacts, threadPool& pool, float deltaTime)
+{
+    ++m_step;
+    colorContacts(world.size(), contacts);
+    prepare(world, deltaTime);
+
+    std::vector<vector2f>& velocities = world.getVelocities();
+    if(m_warmStarting)
+    {
+        forEachBatch(pool, [&](constraint& constraint)
+        {
+            vector2f impulse = constraint.impulse * constraint.normal;
+            velocities[constraint.first] -= impulse * constraint.invMassFirst;
+            velocities[constraint.second] += impulse * constraint.invMassSecond;
+        });
+    }
+
+    for(int iteration = 0; iteration < m_iterations; ++iteration)
+    {
+        forEachBatch(pool, [&](constraint& constraint)
+        {
+            vector2f& first = velocities[constraint.first];
+            vector2f& second = velocities[constraint.second];
+            float approach = dot(second - first, constraint.normal);
+            float total = std::max(constraint.impulse + constraint.mass * (constraint.bias - approach), 0.f);
+            vector2f impulse = (total - constraint.impulse) * constraint.normal;
+            constraint.impulse = total;
+            first -= impulse * constraint.invMassFirst;
+            second += impulse * constraint.invMassSecond;
+        });
+    }
+
+    for(constraint& constraint : m_constraints)
+    {
+        constraint.persistent->normalImpulse = constraint.impulse;
+    }
+    for(auto it = m_manifolds.begin(); it != m_manifolds.end();)
+    {
+        if(it->second.step != m_step)
+            it = m_manifolds.erase(it);
+        else
+            ++it;
+    }
+}
+
+void contactSolver::clear()
+{
+    m_manifolds.clear();
+}
+
+int& contactSolver::getIterations() { return m_iterations; }
+
+bool& contactSolver::getWarmStarting() { return m_warmStarting; }
+
+uint32_t contactSolver::getColorCount() const { return m_colorCount; }
+
+size_t contactSolver::getManifoldCount() const { return m_manifolds.size(); }
+
+void contactSolver::prepare(world& world, float deltaTime)
+{
+    std::vector<bodyInfo>& info = world.getInfo();
+    const std::vector<vector2f>& velocities = world.getVelocities();
+    const std::vector<float>& invMasses = world.getInvMasses();
+
+    m_constraints.resize(m_ordered.size());
+    for(uint32_t i = 0; i < m_ordered.size(); ++i)
+    {
+        const contact& contact = m_ordered[i];
+        constraint& constraint = m_constraints[i];
+        ++info[contact.first].collisions;
+        ++info[contact.second].collisions;
+
+        constraint.first = contact.first;
+        constraint.second = contact.second;
+        constraint.normal = contact.normal;
+        constraint.invMassFirst = invMasses[contact.first];
+        constraint.invMassSecond = invMasses[contact.second];
+        float invMass = constraint.invMassFirst + constraint.invMassSecond;
+        constraint.mass = invMass > 0 ? 1 / invMass : 0.f;
+
+        // Bounce off fast approaches, otherwise push out what penetration exceeds the slop.
+        float approach = dot(velocities[contact.second] - velocities[contact.first], contact.normal);
+        float bounce = approach < -restitutionThreshold ? -physicalObject::restitution * approach : 0.f;
+        float push = baumgarte / deltaTime * std::max(contact.penetration - slop, 0.f);
+        constraint.bias = std::max(bounce, push);
+
+        bodyHandle first = world.getHandle(contact.first);
+        bodyHandle second = world.getHandle(contact.second);
+        bool swapped = second.slot < first.slot;
+        if(swapped)
+            std::swap(first, second);
+        vector2f normal = swapped ? -contact.normal : contact.normal;
+        manifold& persistent = m_manifolds[uint64_t(first.slot) << 32 | second.slot];
+        // A new pair, recycled slots or a normal that turned too far start from nothing.
+        bool matches = persistent.step + 1 == m_step && persistent.firstGeneration == first.generation &&
+                       persistent.secondGeneration == second.generation && dot(persistent.normal, normal) > 0.9f;
+        constraint.impulse = m_warmStarting && matches ? persistent.normalImpulse : 0.f;
+        persistent.normal = normal;
+        persistent.normalImpulse = 0.f;
+        persistent.firstGeneration = first.generation;
+        persistent.secondGeneration = second.generation;
+        persistent.step = m_step;
+        constraint.persistent = &persistent;
+    }
+}
+
+void contactSolver::colorContacts(uint32_t bodyCount, const std::vector<contact>& contacts)
+{
+    m_bodyColors.assign(bodyCount, 0);
+    m_contactColors.resize(contacts.size());
+    std::fill(m_batchOffsets.begin(), m_batchOffsets.end(), 0);
+
+    m_colorCount = 0;
+    for(uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        uint64_t& first = m_bodyColors[contacts[i].first];
+        uint64_t& second = m_bodyColors[contacts[i].second];
+        uint64_t free = ~(first | second);
+        uint32_t color = maxColors;
+        if(free != 0)
+        {
+            color = lowestSetBit(free);
+            first |= uint64_t(1) << color;
+            second |= uint64_t(1) << color;
+        }
+        m_contactColors[i] = static_cast<uint8_t>(color);
+        ++m_batchOffsets[color + 1];
+        m_colorCount = std::max(m_colorCount, color + 1);
+    }
+
+    // Counting sort by color.
+    for(uint32_t color = 1; color < m_batchOffsets.size(); ++color)
+    {
+        m_batchOffsets[color] += m_batchOffsets[color - 1];
+    }
+    std::array<uint32_t, maxColors + 1> cursor;
+    std::copy(m_batchOffsets.begin(), m_batchOffsets.begin() + cursor.size(), cursor.begin());
+    m_ordered.resize(contacts.size());
+    for(uint32_t i = 0; i < contacts.size(); ++i)
+    {
+        m_ordered[cursor[m_contactColors[i]]++] = contacts[i];
+    }
+}
+
+} // namespace kq
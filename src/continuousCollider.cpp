@@ -0,0 +1,156 @@
+#include "continuousCollider.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kq
+{
+
+namespace
+{
+
+// How far the inner circles are pushed into each other at the time of impact, as a fraction of
+// the smaller radius, so the narrowphase sees a contact instead of two shapes just touching.
+constexpr float impactOverlap = 0.1f;
+
+} // namespace
+
+continuousCollider::continuousCollider()
+    : m_enabled(true), m_fastCount(0), m_impactCount(0), m_fast(), m_fastBodies(), m_impacts(), m_hitBodies()
+{
+
+}
+
+void continuousCollider::solve(world& world, const std::vector<collisionPair>& pairs)
+{
+    if(!findFastBodies(world))
+        return;
+
+    for(const collisionPair& pair : pairs)
+    {
+        if(m_fast[pair.first] || m_fast[pair.second])
+            sweep(world, pair.first, pair.second);
+    }
+    rewind(world);
+}
+
+void continuousCollider::solveAll(world& world)
+{
+    if(!findFastBodies(world))
+        return;
+
+    for(uint32_t first : m_fastBodies)
+    {
+        for(uint32_t second = 0; second < world.size(); ++second)
+        {
+            // Pairs of two fast bodies are swept once, from the lower index.
+            if(second != first && !(m_fast[second] && second < first))
+                sweep(world, first, second);
+        }
+    }
+    rewind(world);
+}
+
+bool& continuousCollider::getEnabled() { return m_enabled; }
+
+uint32_t continuousCollider::getFastCount() const { return m_fastCount; }
+
+uint32_t continuousCollider::getImpactCount() const { return m_impactCount; }
+
+const std::vector<uint32_t>& continuousCollider::getRewound() const { return m_hitBodies; }
+
+float continuousCollider::innerRadius(const world& world, uint32_t index)
+{
+    vector2f extents = world.getExtents()[index];
+    switch(world.getTypes()[index])
+    {
+        case objectType::Circle:
+            return extents.x;
+        case objectType::Triangle:
+            // Inradius of an equilateral triangle, its center is the centroid.
+            return extents.x / (2.f * std::sqrt(3.f));
+        case objectType::Convex:
+            return world.getPolygon(index).getInnerRadius();
+        case objectType::Square:
+        case objectType::Rectangle:
+        default:
+            return std::min(extents.x, extents.y) / 2.f;
+    }
+}
+
+bool continuousCollider::findFastBodies(const world& world)
+{
+    const uint32_t count = world.size();
+    const std::vector<vector2f>& positions = world.getPositions();
+    const std::vector<vector2f>& previous = world.getPreviousPositions();
+
+    m_fastBodies.clear();
+    m_hitBodies.clear();
+    m_impactCount = 0;
+    if(!m_enabled)
+    {
+        m_fastCount = 0;
+        return false;
+    }
+
+    m_fast.assign(count, 0);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        vector2f travel = positions[i] - previous[i];
+        float radius = innerRadius(world, i);
+        if(travel.x * travel.x + travel.y * travel.y > radius * radius)
+        {
+            m_fast[i] = 1;
+            m_fastBodies.push_back(i);
+        }
+    }
+    m_fastCount = static_cast<uint32_t>(m_fastBodies.size());
+    m_impacts.assign(count, 1.f);
+    return m_fastCount != 0;
+}
+
+void continuousCollider::sweep(const world& world, uint32_t first, uint32_t second)
+{
+    const std::vector<vector2f>& positions = world.getPositions();
+    const std::vector<vector2f>& previous = world.getPreviousPositions();
+    float radius1 = innerRadius(world, first);
+    float radius2 = innerRadius(world, second);
+    float distance = radius1 + radius2 - impactOverlap * std::min(radius1, radius2);
+
+    // Relative motion of the second body seen from the first: start + motion * t, t in [0, 1].
+    vector2f start = previous[second] - previous[first];
+    vector2f motion = (positions[second] - previous[second]) - (positions[first] - previous[first]);
+    float a = motion.x * motion.x + motion.y * motion.y;
+    float b = 2.f * (start.x * motion.x + start.y * motion.y);
+    float c = start.x * start.x + start.y * start.y - distance * distance;
+    // Already touching at the start of the step, or moving apart: the narrowphase handles it.
+    float touching = radius1 + radius2;
+    if(start.x * start.x + start.y * start.y <= touching * touching || b >= 0.f || a == 0.f)
+        return;
+    float discriminant = b * b - 4.f * a * c;
+    if(discriminant < 0.f)
+        return;
+
+    float time = (-b - std::sqrt(discriminant)) / (2.f * a);
+    if(time < 0.f || time >= 1.f)
+        return;
+
+    for(uint32_t body : {first, second})
+    {
+        if(m_impacts[body] == 1.f)
+            m_hitBodies.push_back(body);
+        m_impacts[body] = std::min(m_impacts[body], time);
+    }
+}
+
+void continuousCollider::rewind(world& world)
+{
+    std::vector<vector2f>& positions = world.getPositions();
+    const std::vector<vector2f>& previous = world.getPreviousPositions();
+    for(uint32_t body : m_hitBodies)
+    {
+        positions[body] = previous[body] + (positions[body] - previous[body]) * m_impacts[body];
+    }
+    m_impactCount = static_cast<uint32_t>(m_hitBodies.size());
+}
+
+} // namespace kq
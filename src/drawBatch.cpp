@@ -0,0 +1,215 @@
+#include "drawBatch.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace kq
+{
+
+namespace
+{
+
+constexpr uint32_t maxCircleSegments = 32;
+
+// Small circles get fewer segments; nobody can tell 8 from 32 on a few pixels.
+uint32_t circleSegments(float radius)
+{
+    if(radius < 4.f)
+        return 8;
+    if(radius < 16.f)
+        return 16;
+    return maxCircleSegments;
+}
+
+// Unit circle points for each segment count, computed once.
+struct unitCircle
+{
+    std::array<vector2f, maxCircleSegments> points8;
+    std::array<vector2f, maxCircleSegments> points16;
+    std::array<vector2f, maxCircleSegments> points32;
+
+    unitCircle()
+    {
+        for(uint32_t i = 0; i < maxCircleSegments; ++i)
+        {
+            points8[i] = {std::cos(i * 2 * pi / 8), std::sin(i * 2 * pi / 8)};
+            points16[i] = {std::cos(i * 2 * pi / 16), std::sin(i * 2 * pi / 16)};
+            points32[i] = {std::cos(i * 2 * pi / 32), std::sin(i * 2 * pi / 32)};
+        }
+    }
+
+    const vector2f* get(uint32_t segments) const
+    {
+        return segments == 8 ? points8.data() : segments == 16 ? points16.data() : points32.data();
+    }
+};
+
+const unitCircle& getUnitCircle()
+{
+    static const unitCircle circle;
+    return circle;
+}
+
+// Outline of a body relative to its position, in order around the shape. Polygons come from the
+// geometry cache, circles are tessellated at a level of detail that suits their radius.
+uint32_t getOutline(const world& world, const geometryCache& geometry, uint32_t index, vector2f* points)
+{
+    if(world.getTypes()[index] == objectType::Circle)
+    {
+        float radius = world.getExtents()[index].x;
+        uint32_t segments = circleSegments(radius);
+        const vector2f* unit = getUnitCircle().get(segments);
+        for(uint32_t i = 0; i < segments; ++i)
+        {
+            points[i] = unit[i] * radius;
+        }
+        return segments;
+    }
+
+    shapeView shape = geometry.getShape(index);
+    vector2f position = geometry.getPositions()[index];
+    for(uint32_t i = 0; i < shape.count; ++i)
+    {
+        points[i] = shape.vertices[i] - position;
+    }
+    return shape.count;
+}
+
+} // namespace
+
+drawBatch::drawBatch()
+    : m_vertices(), m_points(), m_offsets(), m_pointOffsets()
+{
+
+}
+
+void drawBatch::fill(const world& world, const geometryCache& geometry, const std::vector<uint32_t>& candidates,
+                     float interpolation, threadPool& pool, const AABB& visible, float pointSize)
+{
+    const std::vector<AABB>& localBounds = world.getLocalBounds();
+    const uint32_t count = static_cast<uint32_t>(candidates.size());
+
+    // Cull and pick the level of detail first, the counts are turned into offsets below.
+    m_offsets.resize(count + 1);
+    m_pointOffsets.resize(count + 1);
+    m_offsets[0] = 0;
+    m_pointOffsets[0] = 0;
+    pool.parallelFor(count, 4096, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t k = begin; k < end; ++k)
+        {
+            uint32_t i = candidates[k];
+            vector2f position = world.getInterpolatedPosition(i, interpolation);
+            const AABB& local = localBounds[i];
+            uint32_t triangles = 0;
+            uint32_t points = 0;
+            if(visible.overlaps({position + local.min, position + local.max}))
+            {
+                vector2f size = local.max - local.min;
+                if(std::max(size.x, size.y) < pointSize)
+                    points = 1;
+                else
+                    triangles = getVertexCount(world, geometry, i);
+            }
+            m_offsets[k + 1] = triangles;
+            m_pointOffsets[k + 1] = points;
+        }
+    });
+    for(uint32_t k = 0; k < count; ++k)
+    {
+        m_offsets[k + 1] += m_offsets[k];
+        m_pointOffsets[k + 1] += m_pointOffsets[k];
+    }
+    m_vertices.resize(m_offsets.back());
+    m_points.resize(m_pointOffsets.back());
+
+    pool.parallelFor(count, 4096, [&](uint32_t begin, uint32_t end)
+    {
+        vector2f points[maxCircleSegments];
+        for(uint32_t k = begin; k < end; ++k)
+        {
+            uint32_t i = candidates[k];
+            if(m_offsets[k + 1] == m_offsets[k])
+            {
+                if(m_pointOffsets[k + 1] != m_pointOffsets[k])
+                    m_points[m_pointOffsets[k]] = {world.getInterpolatedPosition(i, interpolation), world.getInfo()[i].color, {}};
+                continue;
+            }
+
+            vector2f position = world.getInterpolatedPosition(i, interpolation);
+            rgba color = world.getInfo()[i].color;
+            uint32_t outline = getOutline(world, geometry, i, points);
+
+            // Fan around the first point, the shapes are all convex.
+            vertex* out = m_vertices.data() + m_offsets[k];
+            for(uint32_t point = 1; point + 1 < outline; ++point)
+            {
+                *out++ = {position + points[0], color, {}};
+                *out++ = {position + points[point], color, {}};
+                *out++ = {position + points[point + 1], color, {}};
+            }
+        }
+    });
+}
+
+void drawBatch::addOutline(const world& world, const geometryCache& geometry, uint32_t index, float interpolation, float thickness, rgba color)
+{
+    vector2f points[maxCircleSegments];
+    uint32_t count = getOutline(world, geometry, index, points);
+    vector2f position = world.getInterpolatedPosition(index, interpolation);
+
+    // Pushes every corner out along the mitre of its two edges.
+    vector2f outer[maxCircleSegments];
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        vector2f previous = points[(i + count - 1) % count];
+        vector2f next = points[(i + 1) % count];
+        auto normal = [](vector2f edge)
+        {
+            float length = std::sqrt(edge.x * edge.x + edge.y * edge.y);
+            return vector2f(edge.y / length, -edge.x / length);
+        };
+        vector2f normal1 = normal(points[i] - previous);
+        vector2f normal2 = normal(next - points[i]);
+        // The polygons are centered, so the outward normal points away from the origin.
+        if(normal1.x * points[i].x + normal1.y * points[i].y < 0)
+        {
+            normal1 = -normal1;
+            normal2 = -normal2;
+        }
+        vector2f mitre = normal1 + normal2;
+        float scale = 1.f + normal1.x * normal2.x + normal1.y * normal2.y;
+        outer[i] = points[i] + mitre * (thickness / scale);
+    }
+
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        uint32_t j = (i + 1) % count;
+        m_vertices.push_back({position + points[i], color, {}});
+        m_vertices.push_back({position + outer[i], color, {}});
+        m_vertices.push_back({position + outer[j], color, {}});
+        m_vertices.push_back({position + points[i], color, {}});
+        m_vertices.push_back({position + outer[j], color, {}});
+        m_vertices.push_back({position + points[j], color, {}});
+    }
+}
+
+void drawBatch::clear()
+{
+    m_vertices.clear();
+    m_points.clear();
+}
+
+const std::vector<vertex>& drawBatch::getVertices() const { return m_vertices; }
+
+const std::vector<vertex>& drawBatch::getPoints() const { return m_points; }
+
+uint32_t drawBatch::getVertexCount(const world& world, const geometryCache& geometry, uint32_t index)
+{
+    if(world.getTypes()[index] == objectType::Circle)
+        return (circleSegments(world.getExtents()[index].x) - 2) * 3;
+    // A fan of count - 2 triangles.
+    return (geometry.getVertexCount(index) - 2) * 3;
+}
+
+} // namespace kq
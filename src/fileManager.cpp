@@ -1,113 +1,433 @@
 #include "fileManager.h"
 #include "types.h"
 #include <sstream>
-#include "physim.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include "simulation.h"
+#include "snapshot.h"
+#include "mappedFile.h"
 
 namespace kq
 {
 
-bool fileManager::loadcsv(const std::string& filename, std::vector<physicalObject*>& objects) 
+namespace
 {
-    std::ifstream file(filename);
-    if (file.is_open()) {
-        std::string line;
-        std::getline(file, line); // Skip the first line
-        while (std::getline(file, line)) {
-            std::stringstream ss(line);
-            std::string field;
-
-            sf::Vector2f position;
-            sf::Vector2f velocity;
-            std::array<float, 4> color;
-            float mass;
-            objectType type;
-
-            std::getline(ss, field, ',');
-            position.x = std::stof(field);
-
-            std::getline(ss, field, ',');
-            position.y = std::stof(field);
-
-            std::getline(ss, field, ',');
-            velocity.x = std::stof(field);
-
-            std::getline(ss, field, ',');
-            velocity.y = std::stof(field);
-
-            std::getline(ss, field, ',');
-            color[0] = std::stoi(field) / 255.f;
-
-            std::getline(ss, field, ',');
-            color[1] = std::stoi(field) / 255.f;
-
-            std::getline(ss, field, ',');
-            color[2] = std::stoi(field) / 255.f;
-            color[3] = 255 / 255.f;
-            std::getline(ss, field, ',');
-            mass = std::stof(field);
-
-            std::getline(ss, field, ',');
-            type = static_cast<objectType>(std::stoi(field));
-
-            float radius;
-            sf::Vector2f size;
-            switch(type)
+
+// Bytes of CSV each parse task takes, rows are never split between tasks.
+constexpr size_t csvChunkSize = 1 << 20;
+
+// from_chars reads "nan" and "inf", which would poison the step.
+bool isFinite(vector2f vector)
+{
+    return std::isfinite(vector.x) && std::isfinite(vector.y);
+}
+
+struct fieldReader
+{
+    const char* current;
+    const char* end;
+    const char* error;
+
+    // Reads the next comma separated number, surrounding spaces are allowed.
+    template<typename T>
+    bool next(T& value, const char* name)
+    {
+        if(error != nullptr)
+            return false;
+        while(current < end && (*current == ' ' || *current == '\t'))
+            ++current;
+        if(current >= end)
+        {
+            error = name;
+            return false;
+        }
+        // from_chars rejects a leading '+'.
+        if(*current == '+')
+            ++current;
+        std::from_chars_result result = std::from_chars(current, end, value);
+        if(result.ec != std::errc())
+        {
+            error = name;
+            return false;
+        }
+        current = result.ptr;
+        while(current < end && (*current == ' ' || *current == '\t'))
+            ++current;
+        if(current < end)
+        {
+            if(*current != ',')
             {
-                case objectType::Circle:
-                {
-                    
-                    std::getline(ss, field, ',');
-                    radius = std::stof(field);
-                    break;
-                }
-                case objectType::Square:
-                {
-                    std::getline(ss, field, ',');
-                    radius = std::stof(field);
-                    break;
-                }
-                case objectType::Rectangle:
-                {
-                    
-                    std::getline(ss, field, ',');
-                    size.x = std::stof(field);
-                    std::getline(ss, field, ',');
-                    size.y = std::stof(field);
-                    break;
-                }
-                case objectType::Triangle:
+                error = name;
+                return false;
+            }
+            ++current;
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+void fileManager::parseChunk(const char* begin, const char* end, csvChunk& chunk)
+{
+    // About 60 bytes per row.
+    size_t estimate = static_cast<size_t>(end - begin) / 60 + 1;
+    chunk.positions.reserve(estimate);
+    chunk.velocities.reserve(estimate);
+    chunk.masses.reserve(estimate);
+    chunk.types.reserve(estimate);
+    chunk.extents.reserve(estimate);
+    chunk.colors.reserve(estimate);
+
+    const char* line = begin;
+    while(line < end)
+    {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(end - line)));
+        const char* lineEnd = newline != nullptr ? newline : end;
+        const char* next = newline != nullptr ? newline + 1 : end;
+        if(lineEnd > line && lineEnd[-1] == '\r')
+            --lineEnd;
+        uint64_t number = chunk.lines++;
+
+        const char* first = line;
+        while(first < lineEnd && (*first == ' ' || *first == '\t'))
+            ++first;
+        if(first == lineEnd)
+        {
+            line = next;
+            continue;
+        }
+
+        fieldReader reader = {line, lineEnd, nullptr};
+        vector2f position, velocity, extents;
+        int red = 0, green = 0, blue = 0, type = 0;
+        float mass = 0.f;
+        uint32_t vertexCount = 0;
+        vector2f vertices[polygon::maxVertices];
+        polygon shape;
+        vector2f centroid;
+        reader.next(position.x, "position x") && reader.next(position.y, "position y") &&
+            reader.next(velocity.x, "velocity x") && reader.next(velocity.y, "velocity y") &&
+            reader.next(red, "red") && reader.next(green, "green") && reader.next(blue, "blue") &&
+            reader.next(mass, "mass") && reader.next(type, "type");
+
+        if(reader.error == nullptr)
+        {
+            if(type == static_cast<int>(objectType::Rectangle))
+            {
+                reader.next(extents.x, "width") && reader.next(extents.y, "height");
+            }
+            else if(type == static_cast<int>(objectType::Convex))
+            {
+                // The vertex count, then that many x, y pairs around the position.
+                if(reader.next(vertexCount, "vertex count") && vertexCount >= 3 && vertexCount <= polygon::maxVertices)
                 {
-                    std::getline(ss, field, ',');
-                    radius = std::stof(field);
-                    break;
+                    for(uint32_t i = 0; i < vertexCount && reader.next(vertices[i].x, "vertex x") && reader.next(vertices[i].y, "vertex y"); ++i)
+                    {
+                    }
                 }
             }
-            parent->createObject(type, {}, radius, size, velocity, color, mass);
-            parent->getEntities().back()->getPosition() = position;
+            else if(type >= static_cast<int>(objectType::Circle) && type <= static_cast<int>(objectType::Triangle))
+            {
+                // Radius for circles, side length for squares and triangles.
+                reader.next(extents.x, "size");
+                extents.y = extents.x;
+            }
+        }
+
+        bool convex = type == static_cast<int>(objectType::Convex);
+        std::string message;
+        if(reader.error != nullptr)
+            message = std::string("missing or malformed ") + reader.error;
+        else if(type < static_cast<int>(objectType::Circle) || type > static_cast<int>(objectType::Convex))
+            message = "unknown type " + std::to_string(type);
+        else if(convex && (vertexCount < 3 || vertexCount > polygon::maxVertices))
+            message = "convex bodies need 3 to " + std::to_string(polygon::maxVertices) + " vertices";
+        else if(convex && !polygon::hull(vertices, vertexCount, shape, &centroid))
+            message = "vertices do not span a convex polygon";
+        else if(red < 0 || red > 255 || green < 0 || green > 255 || blue < 0 || blue > 255)
+            message = "color out of range";
+        else if(!(mass > 0.f))
+            message = "mass must be positive";
+        else if(!convex && (!(extents.x > 0.f) || !(extents.y > 0.f) || !isFinite(extents)))
+            message = "size must be positive";
+        else if(!isFinite(position) || !isFinite(velocity))
+            message = "position and velocity must be finite";
 
+        if(message.empty())
+        {
+            if(convex)
+            {
+                // The body sits on the centroid of its vertices.
+                AABB bounds = shape.getBounds();
+                position += centroid;
+                extents = bounds.max - bounds.min;
+                chunk.polygons.push_back(shape);
+            }
+            chunk.positions.push_back(position);
+            chunk.velocities.push_back(velocity);
+            chunk.masses.push_back(mass);
+            chunk.types.push_back(static_cast<objectType>(type));
+            chunk.extents.push_back(extents);
+            chunk.colors.push_back(rgba(static_cast<uint8_t>(red), static_cast<uint8_t>(green), static_cast<uint8_t>(blue)));
+        }
+        else
+        {
+            chunk.errors.push_back({number, std::move(message)});
         }
-        file.close();
-    } else {
+        line = next;
+    }
+}
+
+
+bool fileManager::loadcsv(const std::string& filename)
+{
+    m_errors.clear();
+    mappedFile file;
+    if(!file.open(filename))
+    {
         std::cout << "Failed to open file: " << filename << std::endl;
         return false;
     }
+
+    const char* data = file.data();
+    const size_t size = file.size();
+    // Skip the header line.
+    size_t first = 0;
+    while(first < size && data[first] != '\n')
+        ++first;
+    first = std::min(first + 1, size);
+
+    // Chunks of about csvChunkSize bytes, each moved forward to the start of a line.
+    std::vector<size_t> bounds = {first};
+    for(size_t split = first + csvChunkSize; split < size; split += csvChunkSize)
+    {
+        const char* newline = static_cast<const char*>(std::memchr(data + split, '\n', size - split));
+        if(newline == nullptr)
+            break;
+        size_t next = static_cast<size_t>(newline - data) + 1;
+        if(next > bounds.back() && next < size)
+            bounds.push_back(next);
+        split = next;
+    }
+    bounds.push_back(size);
+
+    std::vector<csvChunk> chunks(bounds.size() - 1);
+    parent->getThreadPool().parallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; ++i)
+        {
+            parseChunk(data + bounds[i], data + bounds[i + 1], chunks[i]);
+        }
+    });
+
+    // Line numbers are counted per chunk and made absolute here; the header is line 1.
+    uint64_t line = 2;
+    world& world = parent->getWorld();
+    for(csvChunk& chunk : chunks)
+    {
+        for(parseError& error : chunk.errors)
+        {
+            error.line += line;
+            m_errors.push_back(std::move(error));
+        }
+        line += chunk.lines;
+
+        uint32_t start = world.append(static_cast<uint32_t>(chunk.positions.size()), chunk.positions.data(), chunk.velocities.data(),
+                                      chunk.masses.data(), chunk.types.data(), chunk.extents.data(), chunk.colors.data(),
+                                      chunk.polygons.data());
+        parent->createEntities(start);
+    }
+
+    for(size_t i = 0; i < m_errors.size() && i < 10; ++i)
+    {
+        std::cout << filename << ":" << m_errors[i].line << ": " << m_errors[i].message << std::endl;
+    }
+    if(m_errors.size() > 10)
+        std::cout << filename << ": " << m_errors.size() - 10 << " more malformed rows" << std::endl;
     return true;
 }
 
-bool fileManager::savecsv(const std::string& filename, const std::vector<physicalObject*>& objects) 
+bool fileManager::savecsv(const std::string& filename)
+{
+    bodyColumns bodies;
+    bodies.capture(parent->getWorld());
+    return sceneWriter::writeCsv(filename, bodies, nullptr);
+}
+
+const std::vector<fileManager::parseError>& fileManager::getErrors() const
 {
-    std::ofstream file(filename);
-    file << "PositionX,PositionY,VelocityX,VelocityY,ColorR,ColorG,ColorB,Mass,Type,Extra1,Extra2\n";
-    if (file.is_open()) {
-        for (const physicalObject* obj : objects) {
-            file <<  obj->toCSVString() << std::endl;
+    return m_errors;
+}
+
+bool fileManager::loadSnapshot(const std::string& filename)
+{
+    m_errors.clear();
+    mappedFile file;
+    if(!file.open(filename))
+    {
+        std::cout << "Failed to open file: " << filename << std::endl;
+        return false;
+    }
+
+    snapshot::header header;
+    if(file.size() < sizeof(header))
+    {
+        std::cout << "Not a snapshot: " << filename << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if(std::memcmp(header.magic, snapshot::magic, sizeof(header.magic)) != 0 || header.byteOrder != snapshot::byteOrder)
+    {
+        std::cout << "Not a snapshot, or written on a machine of the other byte order: " << filename << std::endl;
+        return false;
+    }
+    if(header.version > snapshot::version)
+    {
+        std::cout << "Snapshot version " << header.version << " is newer than this build: " << filename << std::endl;
+        return false;
+    }
+    if(header.columnCount > (file.size() - sizeof(header)) / sizeof(snapshot::columnEntry) || header.bodyCount > UINT32_MAX)
+    {
+        std::cout << "Corrupt snapshot header: " << filename << std::endl;
+        return false;
+    }
+
+    const size_t elementSizes[] = {sizeof(vector2f), sizeof(vector2f), sizeof(float), sizeof(objectType), sizeof(vector2f), sizeof(rgba),
+                                   sizeof(polygon)};
+    static_assert(sizeof(elementSizes) / sizeof(elementSizes[0]) == static_cast<size_t>(snapshot::column::Count), "missing element size");
+    const char* columns[static_cast<size_t>(snapshot::column::Count)] = {};
+    const uint64_t count = header.bodyCount;
+    const uint32_t polygonColumn = static_cast<uint32_t>(snapshot::column::Polygons);
+    uint64_t polygonBytes = 0;
+    for(uint32_t i = 0; i < header.columnCount; ++i)
+    {
+        snapshot::columnEntry entry;
+        std::memcpy(&entry, file.data() + sizeof(header) + i * sizeof(entry), sizeof(entry));
+        if(entry.id >= static_cast<uint32_t>(snapshot::column::Count))
+            continue;
+        // The polygon column is as long as there are convex bodies, checked below.
+        uint64_t elements = entry.id == polygonColumn ? 0 : count;
+        if(entry.elementSize != elementSizes[entry.id] || entry.offset % alignof(vector2f) != 0 ||
+           entry.offset > file.size() || elements * entry.elementSize > file.size() - entry.offset)
+        {
+            std::cout << "Corrupt snapshot column " << entry.id << ": " << filename << std::endl;
+            return false;
+        }
+        columns[entry.id] = file.data() + entry.offset;
+        if(entry.id == polygonColumn)
+            polygonBytes = file.size() - entry.offset;
+    }
+    for(uint32_t id = 0; id < static_cast<uint32_t>(snapshot::column::Count); ++id)
+    {
+        if(columns[id] == nullptr && count != 0 && id != polygonColumn)
+        {
+            std::cout << "Snapshot is missing a column: " << filename << std::endl;
+            return false;
         }
-        file.close();
-    } else {
-        std::cout << "Failed to create file: " << filename << std::endl;
+    }
+
+    auto get = [&](snapshot::column id) { return columns[static_cast<size_t>(id)]; };
+    const vector2f* positions = reinterpret_cast<const vector2f*>(get(snapshot::column::Positions));
+    const vector2f* velocities = reinterpret_cast<const vector2f*>(get(snapshot::column::Velocities));
+    const float* masses = reinterpret_cast<const float*>(get(snapshot::column::Masses));
+    const objectType* types = reinterpret_cast<const objectType*>(get(snapshot::column::Types));
+    const vector2f* extents = reinterpret_cast<const vector2f*>(get(snapshot::column::Extents));
+    const rgba* colors = reinterpret_cast<const rgba*>(get(snapshot::column::Colors));
+    const polygon* polygons = reinterpret_cast<const polygon*>(get(snapshot::column::Polygons));
+
+    // The only per-body pass, with the same checks as a CSV row: the world divides by the mass,
+    // switches on the type and places the body by its position and extents.
+    uint64_t convexCount = 0;
+    for(uint64_t i = 0; i < count; ++i)
+    {
+        int type = static_cast<int>(types[i]);
+        const char* problem = nullptr;
+        if(type < static_cast<int>(objectType::Circle) || type > static_cast<int>(objectType::Convex))
+            problem = "unknown type";
+        else if(!(masses[i] > 0.f))
+            problem = "mass must be positive";
+        else if(!(extents[i].x > 0.f) || !(extents[i].y > 0.f) || !isFinite(extents[i]))
+            problem = "size must be positive";
+        else if(!isFinite(positions[i]) || !isFinite(velocities[i]))
+            problem = "position and velocity must be finite";
+        if(problem != nullptr)
+        {
+            std::cout << "Invalid body " << i << " in snapshot (" << problem << "): " << filename << std::endl;
+            return false;
+        }
+        convexCount += types[i] == objectType::Convex;
+    }
+    if(convexCount != 0 && (polygons == nullptr || convexCount * sizeof(polygon) > polygonBytes))
+    {
+        std::cout << "Snapshot is missing the polygons of its convex bodies: " << filename << std::endl;
         return false;
     }
+    for(uint64_t i = 0; i < convexCount; ++i)
+    {
+        if(polygons[i].count < 3 || polygons[i].count > polygon::maxVertices)
+        {
+            std::cout << "Invalid polygon " << i << " in snapshot: " << filename << std::endl;
+            return false;
+        }
+    }
+
+    world& world = parent->getWorld();
+    if(header.worldSize.x > 0.f && header.worldSize.y > 0.f)
+        world.setSize(header.worldSize);
+    uint32_t first = world.append(static_cast<uint32_t>(count), positions, velocities, masses, types, extents, colors, polygons);
+    parent->createEntities(first);
     return true;
 }
 
+bool fileManager::saveSnapshot(const std::string& filename)
+{
+    bodyColumns bodies;
+    bodies.capture(parent->getWorld());
+    return sceneWriter::writeSnapshot(filename, bodies, nullptr);
+}
+
+bool fileManager::load(const std::string& filename)
+{
+    switch(detectFormat(filename))
+    {
+        case fileFormat::Snapshot:
+            return loadSnapshot(filename);
+        case fileFormat::Csv:
+            return loadcsv(filename);
+        default:
+            std::cout << "Failed to open file: " << filename << std::endl;
+            return false;
+    }
+}
+
+bool fileManager::save(const std::string& filename)
+{
+    if(formatFromExtension(filename) == fileFormat::Snapshot)
+        return saveSnapshot(filename);
+    return savecsv(filename);
+}
+
+fileFormat fileManager::formatFromExtension(const std::string& filename)
+{
+    std::string extension = snapshotExtension;
+    bool binary = filename.size() >= extension.size() &&
+                  filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+    return binary ? fileFormat::Snapshot : fileFormat::Csv;
+}
+
+fileFormat fileManager::detectFormat(const std::string& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if(!file.is_open())
+        return fileFormat::Unknown;
+    char magic[sizeof(snapshot::magic)] = {};
+    file.read(magic, sizeof(magic));
+    if(file.gcount() == sizeof(magic) && std::memcmp(magic, snapshot::magic, sizeof(magic)) == 0)
+        return fileFormat::Snapshot;
+    return fileFormat::Csv;
+}
+
 } //namespace kq
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "geometryCache.h"
+
+namespace kq
+{
+
+namespace
+{
+
+uint32_t vertexCount(const world& world, uint32_t index)
+{
+    switch(world.getTypes()[index])
+    {
+        case objectType::Square:
+        case objectType::Rectangle:
+            return 4;
+        case objectType::Triangle:
+            return 3;
+        case objectType::Convex:
+            return world.getPolygon(index).count;
+        case objectType::Circle:
+        default:
+            return 0;
+    }
+}
+
+} // namespace
+
+uint32_t shapeView::support(vector2f direction) const
+{
+    uint32_t best = 0;
+    float bestDistance = vertices[0].x * direction.x + vertices[0].y * direction.y;
+    for(uint32_t i = 1; i < count; ++i)
+    {
+        float distance = vertices[i].x * direction.x + vertices[i].y * direction.y;
+        if(distance > bestDistance)
+        {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+geometryCache::geometryCache()
+    : m_offsets(1, 0), m_vertices(), m_normals(), m_distances(), m_positions(), m_bounds(), m_sweptBounds(),
+    m_revision(UINT64_MAX)
+{
+
+}
+
+void geometryCache::update(const world& world, threadPool& pool)
+{
+    layout(world);
+    pool.parallelFor(world.size(), 4096, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; ++i)
+        {
+            place(world, i);
+        }
+    });
+}
+
+void geometryCache::refresh(const world& world, const std::vector<uint32_t>& bodies)
+{
+    for(uint32_t body : bodies)
+    {
+        place(world, body);
+    }
+}
+
+void geometryCache::layout(const world& world)
+{
+    if(m_revision == world.getRevision() && size() == world.size())
+        return;
+    m_revision = world.getRevision();
+
+    m_offsets.resize(world.size() + 1);
+    m_offsets[0] = 0;
+    for(uint32_t i = 0; i < world.size(); ++i)
+    {
+        m_offsets[i + 1] = m_offsets[i] + vertexCount(world, i);
+    }
+    m_vertices.resize(m_offsets.back());
+    m_normals.resize(m_offsets.back());
+    m_distances.resize(m_offsets.back());
+    m_positions.resize(world.size());
+    m_bounds.resize(world.size());
+    m_sweptBounds.resize(world.size());
+}
+
+void geometryCache::place(const world& world, uint32_t index)
+{
+    vector2f position = world.getPositions()[index];
+    m_positions[index] = position;
+    m_bounds[index] = world.getBounds(index);
+    m_sweptBounds[index] = world.getSweptBounds(index);
+
+    uint32_t first = m_offsets[index];
+    if(m_offsets[index + 1] == first)
+        return;
+
+    polygon built;
+    const polygon* shape = &built;
+    vector2f extents = world.getExtents()[index];
+    switch(world.getTypes()[index])
+    {
+        case objectType::Square:
+        case objectType::Rectangle:
+            built = polygon::box(extents);
+            break;
+        case objectType::Triangle:
+            built = polygon::triangle(extents.x);
+            break;
+        default:
+            shape = &world.getPolygon(index);
+            break;
+    }
+
+    for(uint32_t i = 0; i < shape->count; ++i)
+    {
+        vector2f vertex = position + shape->vertices[i];
+        vector2f normal = shape->normals[i];
+        m_vertices[first + i] = vertex;
+        m_normals[first + i] = normal;
+        m_distances[first + i] = normal.x * vertex.x + normal.y * vertex.y;
+    }
+}
+
+uint64_t geometryCache::getRevision() const { return m_revision; }
+
+uint32_t geometryCache::size() const { return static_cast<uint32_t>(m_positions.size()); }
+
+const std::vector<AABB>& geometryCache::getBounds() const { return m_bounds; }
+
+const std::vector<AABB>& geometryCache::getSweptBounds() const { return m_sweptBounds; }
+
+const std::vector<vector2f>& geometryCache::getPositions() const { return m_positions; }
+
+shapeView geometryCache::getShape(uint32_t index) const
+{
+    uint32_t first = m_offsets[index];
+    return {m_vertices.data() + first, m_normals.data() + first, m_distances.data() + first, m_offsets[index + 1] - first};
+}
+
+uint32_t geometryCache::getVertexCount(uint32_t index) const { return m_offsets[index + 1] - m_offsets[index]; }
+
+} // namespace kq
@@ -0,0 +1,75 @@
+// Runs a scene without a window: loads a CSV or snapshot, steps it for a number of frames as
+// fast as possible and writes the final state back out, as a snapshot if the output name ends
+// in .psnap and as CSV otherwise.
+//
+// usage: physim_headless <scene> <output> <frames> [frame rate] [threads]
+
+#include "common.h"
+#include "simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+
+namespace
+{
+
+int usage(const char* program)
+{
+    std::cerr << "usage: " << program << " <scene> <output> <frames> [frame rate] [threads]" << std::endl;
+    return 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if(argc < 4)
+        return usage(argv[0]);
+
+    std::string input = argv[1];
+    std::string output = argv[2];
+    long long frames = 0;
+    float frameRate = 60.f;
+    long long threads = 0;
+    try
+    {
+        frames = std::stoll(argv[3]);
+        if(argc > 4)
+            frameRate = std::stof(argv[4]);
+        if(argc > 5)
+            threads = std::stoll(argv[5]);
+    }
+    catch(const std::exception&)
+    {
+        return usage(argv[0]);
+    }
+    // Also rejects a NaN frame rate.
+    if(frames < 0 || frames > UINT32_MAX || !(frameRate > 0) || std::isinf(frameRate) || (argc > 5 && threads <= 0))
+        return usage(argv[0]);
+
+    kq::simulation simulation;
+    if(argc > 5)
+        simulation.getThreadPool().setThreadCount(static_cast<uint32_t>(std::min<long long>(threads, UINT32_MAX)));
+
+    if(!simulation.getFileManager().load(input))
+        return 1;
+
+    // Each frame banks the same time the GUI would at this frame rate, so both produce the same steps.
+    uint64_t steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long long frame = 0; frame < frames; ++frame)
+    {
+        simulation.advance(1.f / frameRate);
+        steps += simulation.getStepCount();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    if(!simulation.getFileManager().save(output))
+        return 1;
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << simulation.getWorld().size() << " bodies, " << frames << " frames, " << steps << " steps in "
+              << seconds << " s (" << (seconds > 0 ? steps / seconds : 0) << " steps/s)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,93 @@
+#include "islandManager.h"
+#include <algorithm>
+#include <numeric>
+
+namespace kq
+{
+
+islandManager::islandManager()
+    : m_enabled(true), m_sleepSpeed(2.f), m_sleepTime(1.f), m_sleeping(0), m_parents(), m_canSleep()
+{
+
+}
+
+void islandManager::update(world& world, const std::vector<contact>& contacts, float deltaTime)
+{
+    const uint32_t count = world.size();
+    if(!m_enabled)
+    {
+        if(m_sleeping != 0)
+            world.wakeAll();
+        m_sleeping = 0;
+        return;
+    }
+
+    std::vector<float>& timers = world.getSleepTimers();
+    const std::vector<vector2f>& velocities = world.getVelocities();
+    const std::vector<uint8_t>& asleep = world.getAsleep();
+    const float limit = m_sleepSpeed * m_sleepSpeed;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(asleep[i])
+            continue;
+        const vector2f& velocity = velocities[i];
+        if(velocity.x * velocity.x + velocity.y * velocity.y < limit)
+            timers[i] += deltaTime;
+        else
+            timers[i] = 0.f;
+    }
+
+    m_parents.resize(count);
+    std::iota(m_parents.begin(), m_parents.end(), 0u);
+    for(const contact& contact : contacts)
+    {
+        unite(contact.first, contact.second);
+    }
+
+    // One moving body keeps its whole island awake.
+    m_canSleep.assign(count, 1);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        if(!asleep[i] && timers[i] < m_sleepTime)
+            m_canSleep[find(i)] = 0;
+    }
+
+    m_sleeping = 0;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        bool canSleep = m_canSleep[find(i)] != 0;
+        if(canSleep && !asleep[i])
+            world.sleep(i);
+        else if(!canSleep && asleep[i])
+            world.wake(i);
+        m_sleeping += asleep[i];
+    }
+}
+
+bool& islandManager::getEnabled() { return m_enabled; }
+
+float& islandManager::getSleepSpeed() { return m_sleepSpeed; }
+
+float& islandManager::getSleepTime() { return m_sleepTime; }
+
+uint32_t islandManager::getSleepingCount() const { return m_sleeping; }
+
+uint32_t islandManager::find(uint32_t index)
+{
+    while(m_parents[index] != index)
+    {
+        m_parents[index] = m_parents[m_parents[index]];
+        index = m_parents[index];
+    }
+    return index;
+}
+
+void islandManager::unite(uint32_t first, uint32_t second)
+{
+    first = find(first);
+    second = find(second);
+    if(first != second)
+        m_parents[std::max(first, second)] = std::min(first, second);
+}
+
+} // namespace kq
@@ -0,0 +1,135 @@
+#include "mappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kq
+{
+
+mappedFile::mappedFile()
+    : m_open(false), m_data(nullptr), m_size(0)
+#if defined(_WIN32)
+    , m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+#endif
+{
+
+}
+
+mappedFile::~mappedFile()
+{
+    close();
+}
+
+#if defined(_WIN32)
+
+bool mappedFile::open(const std::string& filename)
+{
+    close();
+    m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                         FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(m_file, &size))
+    {
+        close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    m_open = true;
+    // Empty files cannot be mapped.
+    if(m_size == 0)
+        return true;
+
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(m_mapping == nullptr)
+    {
+        close();
+        return false;
+    }
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if(m_data == nullptr)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void mappedFile::close()
+{
+    if(m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if(m_mapping != nullptr)
+        CloseHandle(m_mapping);
+    if(m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_file = INVALID_HANDLE_VALUE;
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+bool mappedFile::open(const std::string& filename)
+{
+    close();
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if(descriptor < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode))
+    {
+        ::close(descriptor);
+        return false;
+    }
+    m_size = static_cast<size_t>(status.st_size);
+    m_open = true;
+    if(m_size != 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if(data == MAP_FAILED)
+        {
+            ::close(descriptor);
+            close();
+            return false;
+        }
+        // The file is read front to back.
+        madvise(data, m_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(data);
+    }
+    // The mapping stays valid without the descriptor.
+    ::close(descriptor);
+    return true;
+}
+
+void mappedFile::close()
+{
+    if(m_data != nullptr)
+        munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
+
+bool mappedFile::isOpen() const { return m_open; }
+
+const char* mappedFile::data() const { return m_data; }
+
+size_t mappedFile::size() const { return m_size; }
+
+} // namespace kq
@@ -0,0 +1,506 @@
+#include "narrowphase.h"
+#include "types.h"
+#include "geometryCache.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace kq
+{
+
+namespace narrowphase
+{
+
+namespace
+{
+
+template<objectType Type>
+struct shapeOf { using type = void; };
+template<> struct shapeOf<objectType::Circle> { using type = Circle; };
+template<> struct shapeOf<objectType::Square> { using type = Square; };
+template<> struct shapeOf<objectType::Rectangle> { using type = Rectangle; };
+template<> struct shapeOf<objectType::Triangle> { using type = Triangle; };
+template<> struct shapeOf<objectType::Convex> { using type = Convex; };
+
+constexpr float epaTolerance = 1e-3f;
+constexpr uint32_t maxIterations = 32;
+
+float dot(vector2f a, vector2f b) { return a.x * b.x + a.y * b.y; }
+
+float cross(vector2f a, vector2f b) { return a.x * b.y - a.y * b.x; }
+
+void circleContact(vector2f centerA, float radiusA, vector2f centerB, float radiusB, contact& result)
+{
+    vector2f offset = centerB - centerA;
+    float distance = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    result.normal = distance > 0 ? offset / distance : vector2f{0.f, 1.f};
+    result.penetration = std::max(radiusA + radiusB - distance, 0.f);
+}
+
+// SAT with the circle: the edge the center is farthest out of, then the closest point on it.
+// The normal points from the circle to the polygon.
+bool circlePolygonContact(vector2f center, float radius, const shapeView& shape, contact& result)
+{
+    uint32_t edge = 0;
+    float separation = -std::numeric_limits<float>::max();
+    for(uint32_t i = 0; i < shape.count; ++i)
+    {
+        float distance = dot(shape.normals[i], center) - shape.distances[i];
+        if(distance > radius)
+            return false;
+        if(distance > separation)
+        {
+            separation = distance;
+            edge = i;
+        }
+    }
+
+    vector2f start = shape.vertices[edge];
+    vector2f end = shape.vertices[(edge + 1) % shape.count];
+    vector2f normal = shape.normals[edge];
+    float distance = separation;
+    // Past either end of the edge the closest feature is a corner.
+    bool beforeStart = dot(center - start, end - start) <= 0;
+    bool afterEnd = dot(center - end, start - end) <= 0;
+    if(separation > 0 && (beforeStart || afterEnd))
+    {
+        vector2f offset = center - (beforeStart ? start : end);
+        distance = std::sqrt(dot(offset, offset));
+        if(distance > radius)
+            return false;
+        if(distance > 0)
+            normal = offset / distance;
+    }
+    result.normal = -normal;
+    result.penetration = std::max(radius - distance, 0.f);
+    return true;
+}
+
+// Deepest separation of b out of a's edges.
+float maxSeparation(const shapeView& a, const shapeView& b, uint32_t& edge)
+{
+    float best = -std::numeric_limits<float>::max();
+    for(uint32_t i = 0; i < a.count; ++i)
+    {
+        vector2f normal = a.normals[i];
+        uint32_t deepest = b.support(-normal);
+        float separation = dot(normal, b.vertices[deepest]) - a.distances[i];
+        if(separation > best)
+        {
+            best = separation;
+            edge = i;
+        }
+    }
+    return best;
+}
+
+bool satContact(const shapeView& a, const shapeView& b, contact& result)
+{
+    uint32_t edgeA = 0;
+    uint32_t edgeB = 0;
+    float separationA = maxSeparation(a, b, edgeA);
+    if(separationA > 0)
+        return false;
+    float separationB = maxSeparation(b, a, edgeB);
+    if(separationB > 0)
+        return false;
+
+    // Prefers a's edges on near ties, so a resting pair does not flip its normal every step.
+    if(separationB > separationA + 1e-2f)
+    {
+        result.normal = -b.normals[edgeB];
+        result.penetration = -separationB;
+    }
+    else
+    {
+        result.normal = a.normals[edgeA];
+        result.penetration = -separationA;
+    }
+    return true;
+}
+
+// A vertex of the Minkowski difference a - b, with the polygon vertices it came from.
+struct supportPoint
+{
+    vector2f point;
+    uint8_t first;
+    uint8_t second;
+};
+
+supportPoint makeSupport(const shapeView& a, const shapeView& b, uint32_t first, uint32_t second)
+{
+    return {a.vertices[first] - b.vertices[second], static_cast<uint8_t>(first), static_cast<uint8_t>(second)};
+}
+
+supportPoint support(const shapeView& a, const shapeView& b, vector2f direction)
+{
+    return makeSupport(a, b, a.support(direction), b.support(-direction));
+}
+
+// Closest point to the origin on the segment, dropping the end that does not contribute.
+vector2f closestOnSegment(supportPoint* simplex, uint32_t& count)
+{
+    vector2f edge = simplex[1].point - simplex[0].point;
+    float length = dot(edge, edge);
+    float t = length > 0 ? -dot(simplex[0].point, edge) / length : 0.f;
+    if(t <= 0)
+    {
+        count = 1;
+        return simplex[0].point;
+    }
+    if(t >= 1)
+    {
+        simplex[0] = simplex[1];
+        count = 1;
+        return simplex[0].point;
+    }
+    return simplex[0].point + edge * t;
+}
+
+// Reduces the simplex to its feature closest to the origin. False when the origin is inside or
+// on the simplex, otherwise direction points from the feature to the origin.
+bool closestFeature(supportPoint* simplex, uint32_t& count, vector2f& direction)
+{
+    vector2f closest = simplex[0].point;
+    if(count == 2)
+    {
+        closest = closestOnSegment(simplex, count);
+    }
+    else if(count == 3)
+    {
+        float area = cross(simplex[1].point - simplex[0].point, simplex[2].point - simplex[0].point);
+        bool inside = area != 0;
+        float best = std::numeric_limits<float>::max();
+        supportPoint reduced[2];
+        uint32_t reducedCount = 0;
+        for(uint32_t i = 0; i < 3; ++i)
+        {
+            supportPoint edge[2] = {simplex[i], simplex[(i + 1) % 3]};
+            // Only the edges the origin lies outside of can hold the closest feature.
+            if(area != 0 && area * cross(edge[1].point - edge[0].point, -edge[0].point) >= 0)
+                continue;
+            inside = false;
+            uint32_t edgeCount = 2;
+            vector2f point = closestOnSegment(edge, edgeCount);
+            if(dot(point, point) < best)
+            {
+                best = dot(point, point);
+                closest = point;
+                reduced[0] = edge[0];
+                reduced[1] = edge[1];
+                reducedCount = edgeCount;
+            }
+        }
+        if(inside)
+            return false;
+        count = reducedCount;
+        simplex[0] = reduced[0];
+        simplex[1] = reduced[1];
+    }
+    direction = -closest;
+    return dot(closest, closest) > epaTolerance * epaTolerance;
+}
+
+// GJK on the Minkowski difference: true when it contains the origin, that is when the polygons
+// overlap. The simplex it ends on is left in simplex for EPA and the cache.
+bool gjk(const shapeView& a, const shapeView& b, const simplexCache::simplex* cached,
+         supportPoint* simplex, uint32_t& count)
+{
+    count = 0;
+    if(cached != nullptr && cached->count <= 3)
+    {
+        for(uint32_t i = 0; i < cached->count; ++i)
+        {
+            if(cached->first[i] < a.count && cached->second[i] < b.count)
+                simplex[count++] = makeSupport(a, b, cached->first[i], cached->second[i]);
+        }
+    }
+    if(count == 0)
+        simplex[count++] = support(a, b, a.vertices[0] - b.vertices[0]);
+
+    for(uint32_t iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        vector2f direction;
+        if(!closestFeature(simplex, count, direction))
+            return true;
+        supportPoint next = support(a, b, direction);
+        if(dot(next.point, direction) < 0)
+            return false;
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            // No new vertex, the feature found is already the closest one to the origin.
+            if(simplex[i].first == next.first && simplex[i].second == next.second)
+                return false;
+        }
+        simplex[count++] = next;
+    }
+    return false;
+}
+
+// EPA from a GJK triangle around the origin: grows the polytope toward the edge of the
+// Minkowski difference nearest the origin, which gives the normal from a to b and the depth.
+bool epa(const shapeView& a, const shapeView& b, const supportPoint* simplex, uint32_t count,
+         vector2f& normal, float& depth)
+{
+    if(count < 3)
+        return false;
+    std::array<supportPoint, 2 * polygon::maxVertices + maxIterations> polytope;
+    uint32_t size = 3;
+    std::copy(simplex, simplex + 3, polytope.begin());
+    float area = cross(polytope[1].point - polytope[0].point, polytope[2].point - polytope[0].point);
+    if(area == 0)
+        return false;
+    if(area < 0)
+        std::swap(polytope[1], polytope[2]);
+
+    for(uint32_t iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        uint32_t nearest = 0;
+        float distance = std::numeric_limits<float>::max();
+        for(uint32_t i = 0; i < size; ++i)
+        {
+            vector2f edge = polytope[(i + 1) % size].point - polytope[i].point;
+            float length = std::sqrt(dot(edge, edge));
+            if(length == 0)
+                continue;
+            vector2f edgeNormal = {edge.y / length, -edge.x / length};
+            float edgeDistance = dot(edgeNormal, polytope[i].point);
+            if(edgeDistance < distance)
+            {
+                distance = edgeDistance;
+                nearest = i;
+                normal = edgeNormal;
+            }
+        }
+
+        supportPoint next = support(a, b, normal);
+        depth = std::max(distance, 0.f);
+        if(dot(next.point, normal) - distance < epaTolerance || size == polytope.size())
+            return true;
+        std::copy_backward(polytope.begin() + nearest + 1, polytope.begin() + size, polytope.begin() + size + 1);
+        polytope[nearest + 1] = next;
+        ++size;
+    }
+    return true;
+}
+
+bool polygonContact(const shapeView& a, const shapeView& b, simplexCache::simplex* cached, contact& result)
+{
+    if(a.count + b.count <= satVertexLimit)
+        return satContact(a, b, result);
+
+    supportPoint simplex[3];
+    uint32_t count = 0;
+    bool hit = gjk(a, b, cached, simplex, count);
+    if(cached != nullptr)
+    {
+        cached->count = count;
+        for(uint32_t i = 0; i < count; ++i)
+        {
+            cached->first[i] = simplex[i].first;
+            cached->second[i] = simplex[i].second;
+        }
+    }
+    if(!hit)
+        return false;
+    // The origin on an edge or corner of the simplex: touching, SAT finds the normal.
+    if(!epa(a, b, simplex, count, result.normal, result.penetration))
+        return satContact(a, b, result);
+    return true;
+}
+
+// A shape object's local polygon moved to its position, for the object interface; the step
+// reads placed outlines from the geometry cache instead.
+struct placedPolygon
+{
+    std::array<vector2f, polygon::maxVertices> vertices;
+    std::array<float, polygon::maxVertices> distances;
+
+    placedPolygon(const polygon& shape, vector2f position)
+    {
+        for(uint32_t i = 0; i < shape.count; ++i)
+        {
+            vertices[i] = position + shape.vertices[i];
+            distances[i] = dot(shape.normals[i], vertices[i]);
+        }
+    }
+
+    shapeView view(const polygon& shape) const
+    {
+        return {vertices.data(), shape.normals.data(), distances.data(), shape.count};
+    }
+};
+
+template<objectType A, objectType B>
+bool test(const physicalObject& a, const physicalObject& b, contact& result, simplexCache* cache)
+{
+    using shapeA = typename shapeOf<A>::type;
+    using shapeB = typename shapeOf<B>::type;
+
+    if constexpr (B < A)
+    {
+        if(!test<B, A>(b, a, result, cache))
+            return false;
+        std::swap(result.first, result.second);
+        std::swap(result.firstType, result.secondType);
+        result.normal = -result.normal;
+        return true;
+    }
+    else
+    {
+        const shapeA& first = static_cast<const shapeA&>(a);
+        const shapeB& second = static_cast<const shapeB&>(b);
+        if constexpr (A == objectType::Circle && B == objectType::Circle)
+        {
+            vector2f offset = second.getPosition() - first.getPosition();
+            float reach = first.getRadius() + second.getRadius();
+            if(dot(offset, offset) >= reach * reach)
+                return false;
+            circleContact(first.getPosition(), first.getRadius(), second.getPosition(), second.getRadius(), result);
+        }
+        else if constexpr (A == objectType::Circle)
+        {
+            const polygon& shape = second.getPolygon();
+            placedPolygon placed(shape, second.getPosition());
+            if(!circlePolygonContact(first.getPosition(), first.getRadius(), placed.view(shape), result))
+                return false;
+        }
+        else
+        {
+            const polygon& polygonA = first.getPolygon();
+            const polygon& polygonB = second.getPolygon();
+            placedPolygon placedA(polygonA, first.getPosition());
+            placedPolygon placedB(polygonB, second.getPosition());
+            simplexCache::simplex* cached = nullptr;
+            if(cache != nullptr && polygonA.count + polygonB.count > satVertexLimit)
+                cached = &cache->get(first.getHandle().slot, second.getHandle().slot);
+            if(!polygonContact(placedA.view(polygonA), placedB.view(polygonB), cached, result))
+                return false;
+        }
+        result.first = first.getIndex();
+        result.second = second.getIndex();
+        result.firstType = A;
+        result.secondType = B;
+        return true;
+    }
+}
+
+template<size_t... Indices>
+constexpr std::array<testFunction, typeCount * typeCount> makeTable(std::index_sequence<Indices...>)
+{
+    return {{ &test<static_cast<objectType>(Indices / typeCount), static_cast<objectType>(Indices % typeCount)>... }};
+}
+
+constexpr std::array<testFunction, typeCount * typeCount> table = makeTable(std::make_index_sequence<typeCount * typeCount>{});
+
+} // namespace
+
+simplexCache::simplexCache()
+    : m_simplices(), m_step(1)
+{
+
+}
+
+simplexCache::simplex& simplexCache::get(uint32_t firstSlot, uint32_t secondSlot)
+{
+    simplex& entry = m_simplices[static_cast<uint64_t>(firstSlot) << 32 | secondSlot];
+    entry.step = m_step;
+    return entry;
+}
+
+void simplexCache::endStep()
+{
+    for(auto it = m_simplices.begin(); it != m_simplices.end();)
+    {
+        if(it->second.step != m_step)
+            it = m_simplices.erase(it);
+        else
+            ++it;
+    }
+    ++m_step;
+}
+
+void simplexCache::clear()
+{
+    m_simplices.clear();
+}
+
+size_t simplexCache::size() const { return m_simplices.size(); }
+
+testFunction getTest(objectType a, objectType b)
+{
+    return table[static_cast<size_t>(a) * typeCount + static_cast<size_t>(b)];
+}
+
+bool collide(const physicalObject& a, const physicalObject& b, contact& result, simplexCache* cache)
+{
+    return getTest(a.getObjectType(), b.getObjectType())(a, b, result, cache);
+}
+
+bool collide(const physicalObject& a, const physicalObject& b)
+{
+    contact result;
+    return collide(a, b, result);
+}
+
+bool collide(const world& world, const geometryCache& geometry, uint32_t first, uint32_t second, contact& result,
+             simplexCache* cache)
+{
+    const std::vector<objectType>& types = world.getTypes();
+    if(types[second] == objectType::Circle && types[first] != objectType::Circle)
+    {
+        if(!collide(world, geometry, second, first, result, cache))
+            return false;
+        std::swap(result.first, result.second);
+        std::swap(result.firstType, result.secondType);
+        result.normal = -result.normal;
+        return true;
+    }
+
+    vector2f center = world.getPositions()[first];
+    float radius = world.getExtents()[first].x;
+    if(types[first] == objectType::Circle && types[second] == objectType::Circle)
+    {
+        vector2f offset = world.getPositions()[second] - center;
+        float reach = radius + world.getExtents()[second].x;
+        if(dot(offset, offset) >= reach * reach)
+            return false;
+        circleContact(center, radius, world.getPositions()[second], world.getExtents()[second].x, result);
+    }
+    else if(types[first] == objectType::Circle)
+    {
+        if(!circlePolygonContact(center, radius, geometry.getShape(second), result))
+            return false;
+    }
+    else
+    {
+        shapeView shapeA = geometry.getShape(first);
+        shapeView shapeB = geometry.getShape(second);
+        simplexCache::simplex* cached = nullptr;
+        if(cache != nullptr && shapeA.count + shapeB.count > satVertexLimit)
+            cached = &cache->get(world.getHandle(first).slot, world.getHandle(second).slot);
+        if(!polygonContact(shapeA, shapeB, cached, result))
+            return false;
+    }
+    result.first = first;
+    result.second = second;
+    result.firstType = types[first];
+    result.secondType = types[second];
+    return true;
+}
+
+void circleContact(const world& world, uint32_t first, uint32_t second, contact& result)
+{
+    circleContact(world.getPositions()[first], world.getExtents()[first].x,
+                  world.getPositions()[second], world.getExtents()[second].x, result);
+    result.first = first;
+    result.second = second;
+    result.firstType = objectType::Circle;
+    result.secondType = objectType::Circle;
+}
+
+} // namespace narrowphase
+
+} // namespace kq
@@ -0,0 +1,39 @@
+#include "objectPool.h"
+
+namespace kq
+{
+
+objectPool::objectPool()
+    : m_blocks(), m_free(), m_used(0)
+{
+
+}
+
+void objectPool::destroy(physicalObject* object)
+{
+    object->~physicalObject();
+    m_free.push_back(object);
+}
+
+void objectPool::reset()
+{
+    m_free.clear();
+    m_used = 0;
+}
+
+void* objectPool::allocate()
+{
+    if(!m_free.empty())
+    {
+        void* memory = m_free.back();
+        m_free.pop_back();
+        return memory;
+    }
+
+    size_t block = m_used / blockSize;
+    if(block == m_blocks.size())
+        m_blocks.push_back(std::make_unique<slot[]>(blockSize));
+    return &m_blocks[block][m_used++ % blockSize];
+}
+
+} // namespace kq
@@ -1,12 +1,18 @@
 #include "physim.h"
+#include <algorithm>
+#include <cmath>
 
 namespace kq
 {
 
 physim::physim()
     : m_width(SCREEN_WIDTH), m_height(SCREEN_LENGTH), m_window(sf::VideoMode(m_width, m_height), "physim", sf::Style::None),
-    m_UIManager(this), m_entities(), m_fileManager(this)
+    m_camera(sf::FloatRect(0.f, 0.f, m_width, m_height)), m_panning(false), m_panStart(),
+    m_UIManager(this), m_simulation(), m_simulationThread(m_simulation), m_state(nullptr), m_pick(), m_renderer(),
+    m_drawPool(std::max(threadPool::getHardwareThreads() / 4, 1u))
 {
+    m_simulation.getThreadPool().setThreadCount(getMaxSimulationThreads());
+    m_state = &m_simulationThread.getState();
     m_window.setFramerateLimit(60);
     (void)ImGui::SFML::Init(m_window);
 }
@@ -18,98 +24,198 @@ physim::~physim()
 
 void physim::run()
 {
-    sf::Clock clock;
+    profiler& profile = m_simulation.getProfiler();
+    m_simulationThread.setView(getViewBounds());
+    m_simulationThread.start();
     while (m_window.isOpen())
     {
-        sf::Event event;
-        while (m_window.pollEvent(event))
+        profile.beginFrame();
         {
-            ImGui::SFML::ProcessEvent(event);
+            profiler::scope timer(profile, profilePhase::Update);
+            updateObjects();
+        }
+        pollEvents();
+
+        ImGui::SFML::Update(m_window, sf::seconds(1.f / 60.f));
+
+        m_window.clear(sf::Color(50, 50, 50));
+
+        {
+            profiler::scope timer(profile, profilePhase::Draw);
+            m_window.setView(m_camera);
+            drawObjects();
+            m_window.setView(m_window.getDefaultView());
+        }
+        {
+            profiler::scope timer(profile, profilePhase::UI);
+            mainMenu();
+        }
+        {
+            profiler::scope timer(profile, profilePhase::Render);
+            ImGui::SFML::Render(m_window);
+        }
+        {
+            // Includes the wait for the frame rate limit.
+            profiler::scope timer(profile, profilePhase::Display);
+            m_window.display();
+        }
+        profile.endFrame();
+    }
+    m_simulationThread.stop();
+}
 
-            if (event.type == sf::Event::Closed)
+void physim::pollEvents()
+{
+    profiler::scope timer(m_simulation.getProfiler(), profilePhase::Events);
+    sf::Event event;
+    while (m_window.pollEvent(event))
+    {
+        ImGui::SFML::ProcessEvent(event);
+
+        if (event.type == sf::Event::Closed)
+        {
+            m_window.close();
+            break;
+        }
+        else if(event.type == sf::Event::KeyPressed)
+        {
+            if(event.key.code == sf::Keyboard::Escape)
             {
-                m_window.close();
-                break;
+                m_UIManager.toggle();
             }
-            else if(event.type == sf::Event::KeyPressed)
+            else if(event.key.code == sf::Keyboard::Space)
             {
-                if(event.key.code == sf::Keyboard::Escape)
-                {
-                    m_UIManager.toggle();
-                }
-                else if(event.key.code == sf::Keyboard::Space)
+                if(m_UIManager.isPlaying())
+                    m_UIManager.pause();
+                else
+                    m_UIManager.play();
+            }
+            else if(event.key.code == sf::Keyboard::Home)
+            {
+                resetCamera();
+            }
+            else if(event.key.code == sf::Keyboard::Delete && !ImGui::GetIO().WantCaptureKeyboard)
+            {
+                if(m_UIManager.isSelected())
                 {
-                    if(m_UIManager.isPlaying())
-                        m_UIManager.pause();
-                    else
-                        m_UIManager.play();
+                    bodyHandle handle = m_UIManager.getSelectedHandle();
+                    m_simulationThread.post([handle](simulation& simulation) { simulation.removeObject(handle); });
                 }
             }
-            else if(event.type == sf::Event::MouseButtonPressed)
+        }
+        else if(event.type == sf::Event::MouseWheelScrolled)
+        {
+            if(!ImGui::GetIO().WantCaptureMouse)
+                zoomCamera(event.mouseWheelScroll.delta, {event.mouseWheelScroll.x, event.mouseWheelScroll.y});
+        }
+        else if(event.type == sf::Event::MouseMoved)
+        {
+            if(m_panning)
             {
-                if(event.mouseButton.button == sf::Mouse::Left)
+                sf::Vector2i pixel = {event.mouseMove.x, event.mouseMove.y};
+                m_camera.move(toSFML(toWorld(m_panStart) - toWorld(pixel)));
+                m_panStart = pixel;
+            }
+        }
+        else if(event.type == sf::Event::MouseButtonReleased)
+        {
+            if(event.mouseButton.button == sf::Mouse::Middle)
+                m_panning = false;
+        }
+        else if(event.type == sf::Event::MouseButtonPressed)
+        {
+            if(event.mouseButton.button == sf::Mouse::Left)
+            {
+                if(!m_UIManager.isActive())
                 {
-                    if(!m_UIManager.isActive())
-                    {
-                        auto type = m_UIManager.getType();
-                        auto rotation = m_UIManager.getRotation();
-                        auto radius = m_UIManager.getRadius();
-                        auto size = m_UIManager.getSize();
-                        auto velocity = m_UIManager.getVelocity();
-                        auto color = m_UIManager.getColor();
-                        auto mass = m_UIManager.getMass();
-                        createObject(type, rotation, radius, size, velocity, color, mass);
-                    }
+                    auto type = m_UIManager.getType();
+                    auto rotation = m_UIManager.getRotation();
+                    auto radius = m_UIManager.getRadius();
+                    auto size = m_UIManager.getSize();
+                    auto sides = m_UIManager.getSides();
+                    auto velocity = m_UIManager.getVelocity();
+                    auto color = m_UIManager.getColor();
+                    auto mass = m_UIManager.getMass();
+                    createObject(type, rotation, radius, size, sides, velocity, color, mass);
                 }
             }
+            else if(event.mouseButton.button == sf::Mouse::Right)
+            {
+                selectAt(toWorld({event.mouseButton.x, event.mouseButton.y}));
+            }
+            else if(event.mouseButton.button == sf::Mouse::Middle)
+            {
+                m_panning = true;
+                m_panStart = {event.mouseButton.x, event.mouseButton.y};
+            }
         }
+    }
+}
 
+void physim::drawObjects()
+{
+    const simulationState& state = *m_state;
+    m_renderer.draw(m_window, state.bodies, state.geometry, state.visible,
+                    state.getInterpolation(simulationState::clock::now()), m_drawPool, m_UIManager.isSelected(),
+                    m_UIManager.getSelected());
+}
 
-        ImGui::SFML::Update(m_window, sf::seconds(1.f / 60.f));
-
-        float deltaTime = clock.restart().asSeconds();
-        m_window.clear(sf::Color(50, 50, 50));
+void physim::updateObjects()
+{
+    // The simulation advances on its own clock, the frame only tells it whether to and takes
+    // the latest state, without waiting for a step.
+    m_simulationThread.setPlaying(m_UIManager.isPlaying());
+    m_simulationThread.setView(getViewBounds());
+    m_state = &m_simulationThread.getState();
 
-        updateObjects(deltaTime);
-        drawObjects();
-        mainMenu();
+    if(m_pick != nullptr && m_pick->done)
+    {
+        if(m_pick->body.slot != bodyHandle::invalidSlot)
+            m_UIManager.select(m_pick->body);
+        m_pick.reset();
+    }
+}
 
-        ImGui::SFML::Render(m_window);
+void physim::zoomCamera(float delta, sf::Vector2i pixel)
+{
+    // Keep the point under the cursor in place.
+    vector2f before = toWorld(pixel);
+    m_camera.zoom(std::pow(1.1f, -delta));
+    m_camera.move(toSFML(before - toWorld(pixel)));
+}
 
-        m_window.display();
-    }
+vector2f physim::toWorld(sf::Vector2i pixel) const
+{
+    return fromSFML(m_window.mapPixelToCoords(pixel, m_camera));
 }
 
-void physim::drawObjects()
+AABB physim::getViewBounds() const
 {
-    uint32_t i = 0;
-    for(auto& entity : m_entities)
-    {
-        physicalObject::m_outline = m_UIManager.isSelected() && i == m_UIManager.getSelected();
-        entity->draw(m_window);
-        ++i;
-    }
+    vector2f center = fromSFML(m_camera.getCenter());
+    vector2f size = fromSFML(m_camera.getSize());
+    return {center - size / 2.f, center + size / 2.f};
 }
 
-void physim::updateObjects(float deltaTime)
+void physim::resetCamera()
 {
-    if(!m_UIManager.isPlaying())
-        return;
-    for(auto& entity : m_entities)
-    {
-        entity->update(deltaTime);
-    }
+    vector2f worldSize = getState().bodies.getSize();
+    float scale = std::max(worldSize.x / m_width, worldSize.y / m_height);
+    m_camera.setSize(m_width * scale, m_height * scale);
+    m_camera.setCenter(toSFML(worldSize / 2.f));
+}
 
-    for(auto& entity1 : m_entities)
+void physim::selectAt(vector2f point)
+{
+    m_pick = std::make_shared<pickResult>();
+    m_simulationThread.post([pick = m_pick, point](simulation& simulation)
     {
-        for(auto& entity2 : m_entities)
-        {
-            if(entity1 != entity2 && entity1->collidesWith(*entity2))
-            {
-                physicalObject::resolveCollision(*entity1, *entity2);
-            }
-        }
-    }
+        std::vector<uint32_t> hits;
+        simulation.getCollider().queryPoint(simulation.getWorld(), point, hits);
+        // The most recently created body is drawn on top.
+        if(!hits.empty())
+            pick->body = simulation.getWorld().getHandle(*std::max_element(hits.begin(), hits.end()));
+        pick->done = true;
+    });
 }
 
 void physim::mainMenu()
@@ -122,63 +228,42 @@ void physim::mainMenu()
     }
 }
 
-const std::vector<physicalObject*>& physim::getEntities() const
+const simulationState& physim::getState() const
 {
-    return m_entities;
+    return *m_state;
 }
 
-std::vector<physicalObject*>& physim::getEntities()
+simulationThread& physim::getSimulationThread()
 {
-    return m_entities;
+    return m_simulationThread;
 }
 
-fileManager& physim::getFileManager()
+profiler& physim::getProfiler()
 {
-    return m_fileManager;
+    return m_simulation.getProfiler();
 }
 
-void physim::clearEntities()
+uint32_t physim::getMaxSimulationThreads() const
 {
-    for(auto& entity : m_entities)
-    {
-        delete entity;
-    }
-    m_entities.clear();
+    return std::max(threadPool::getHardwareThreads() - m_drawPool.getThreadCount(), 1u);
 }
 
-void physim::Impulse()
+void physim::createObject(objectType type, float orientation, float radius, vector2f size, int sides,
+                 vector2f velocity, std::array<float, 4> colors, float mass)
 {
-    for(auto& entity : m_entities)
-    {
-        sf::Vector2f random = {static_cast<float>(rand() % 350 + 100) * entity->getMass() / 2,
-                                static_cast<float>(rand() % 350 + 100) * entity->getMass() / 2};
-        entity->applyForce(random);
-    }
-}
-
-void physim::createObject(objectType type, float orientation, float radius, sf::Vector2f size,
-                 sf::Vector2f velocity, std::array<float, 4> colors, float mass)
-{
-    sf::Color color(colors[0] * 255, colors[1]  * 255, colors[2]  * 255, colors[3] * 255);
-    sf::Vector2 mousePosF = static_cast<sf::Vector2f>(sf::Mouse::getPosition(m_window));
+    rgba color(colors[0] * 255, colors[1]  * 255, colors[2]  * 255, colors[3] * 255);
+    vector2f mousePosF = toWorld(sf::Mouse::getPosition(m_window));
 
-    if(type == objectType::Circle)
-    {
-        m_entities.push_back(new Circle({mousePosF, velocity, color, mass, type}, radius));
-    }
-    if(type == objectType::Square)
+    if(type == objectType::Convex)
     {
-        m_entities.push_back(new Square({mousePosF, velocity, color, mass, type}, radius));
-    }
-    if(type == objectType::Rectangle)
-    {
-        m_entities.push_back(new Rectangle({mousePosF, velocity, color, mass, type}, size.x, size.y));
+        polygon shape = polygon::regular(sides, radius, orientation);
+        m_simulationThread.post([=](simulation& simulation) { simulation.createObject(mousePosF, velocity, color, mass, shape); });
+        return;
     }
-    if(type == objectType::Triangle)
+    m_simulationThread.post([=](simulation& simulation)
     {
-        m_entities.push_back(new Triangle({mousePosF, velocity, color, mass, type}, radius));
-    }
+        simulation.createObject(type, mousePosF, velocity, color, mass, radius, size);
+    });
 }
 
-} // namespace kq
-
+} // namespace kq
\ No newline at end of file
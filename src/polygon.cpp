@@ -0,0 +1,159 @@
+#include "polygon.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace kq
+{
+
+namespace
+{
+
+float cross(vector2f a, vector2f b) { return a.x * b.y - a.y * b.x; }
+
+float dot(vector2f a, vector2f b) { return a.x * b.x + a.y * b.y; }
+
+} // namespace
+
+polygon polygon::box(vector2f size)
+{
+    vector2f half = size / 2.0f;
+    polygon result;
+    result.count = 4;
+    result.vertices[0] = {-half.x, -half.y};
+    result.vertices[1] = {half.x, -half.y};
+    result.vertices[2] = {half.x, half.y};
+    result.vertices[3] = {-half.x, half.y};
+    result.normals[0] = {0.f, -1.f};
+    result.normals[1] = {1.f, 0.f};
+    result.normals[2] = {0.f, 1.f};
+    result.normals[3] = {-1.f, 0.f};
+    return result;
+}
+
+polygon polygon::triangle(float side)
+{
+    // Equilateral, the base height / 3 above the centroid and the apex 2 * height / 3 below it.
+    float height = side * std::sqrt(3.f) / 2.0f;
+    polygon result;
+    result.count = 3;
+    result.vertices[0] = {-side / 2.0f, -height / 3};
+    result.vertices[1] = {side / 2.0f, -height / 3};
+    result.vertices[2] = {0.f, 2 * height / 3};
+    result.normals[0] = {0.f, -1.f};
+    result.normals[1] = {std::sqrt(3.f) / 2.0f, 0.5f};
+    result.normals[2] = {-std::sqrt(3.f) / 2.0f, 0.5f};
+    return result;
+}
+
+polygon polygon::regular(uint32_t sides, float radius, float rotation)
+{
+    sides = std::clamp<uint32_t>(sides, 3, maxVertices);
+    polygon result;
+    result.count = sides;
+    for(uint32_t i = 0; i < sides; ++i)
+    {
+        float angle = rotation + i * 2 * pi / sides;
+        result.vertices[i] = {radius * std::cos(angle), radius * std::sin(angle)};
+    }
+    result.computeNormals();
+    return result;
+}
+
+bool polygon::hull(const vector2f* points, uint32_t count, polygon& result, vector2f* centroid)
+{
+    // Monotone chain: the lower hull left to right, then the upper hull back.
+    std::vector<vector2f> sorted(points, points + count);
+    std::sort(sorted.begin(), sorted.end(), [](vector2f a, vector2f b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+    std::vector<vector2f> hull(2 * sorted.size() + 1);
+    size_t size = 0;
+    for(size_t pass = 0; pass < 2; ++pass)
+    {
+        size_t lower = size;
+        for(size_t i = 0; i < sorted.size(); ++i)
+        {
+            vector2f point = pass == 0 ? sorted[i] : sorted[sorted.size() - 1 - i];
+            while(size >= lower + 2 && cross(hull[size - 1] - hull[size - 2], point - hull[size - 2]) <= 0)
+                --size;
+            hull[size++] = point;
+        }
+        // The last point of each chain starts the other one.
+        --size;
+    }
+    if(size < 3 || size > maxVertices)
+        return false;
+    // Keeps the caller's first point first when it is on the hull, so saved shapes load unchanged.
+    std::rotate(hull.begin(), std::find(hull.begin(), hull.begin() + size, points[0]), hull.begin() + size);
+
+    // Area-weighted centroid of the fan around the first vertex.
+    float area = 0.f;
+    vector2f center = {0.f, 0.f};
+    for(size_t i = 1; i + 1 < size; ++i)
+    {
+        float triangleArea = cross(hull[i] - hull[0], hull[i + 1] - hull[0]) / 2;
+        area += triangleArea;
+        center += (hull[0] + hull[i] + hull[i + 1]) * (triangleArea / 3);
+    }
+    if(!(area > 1e-6f))
+        return false;
+    center /= area;
+
+    result.count = static_cast<uint32_t>(size);
+    for(uint32_t i = 0; i < result.count; ++i)
+    {
+        result.vertices[i] = hull[i] - center;
+    }
+    result.computeNormals();
+    if(centroid != nullptr)
+        *centroid = center;
+    return true;
+}
+
+void polygon::computeNormals()
+{
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        vector2f edge = vertices[(i + 1) % count] - vertices[i];
+        float length = std::sqrt(dot(edge, edge));
+        normals[i] = length > 0 ? vector2f(edge.y / length, -edge.x / length) : vector2f(0.f, 0.f);
+    }
+}
+
+AABB polygon::getBounds() const
+{
+    AABB bounds = {vertices[0], vertices[0]};
+    for(uint32_t i = 1; i < count; ++i)
+    {
+        bounds.min = {std::min(bounds.min.x, vertices[i].x), std::min(bounds.min.y, vertices[i].y)};
+        bounds.max = {std::max(bounds.max.x, vertices[i].x), std::max(bounds.max.y, vertices[i].y)};
+    }
+    return bounds;
+}
+
+float polygon::getInnerRadius() const
+{
+    float radius = dot(normals[0], vertices[0]);
+    for(uint32_t i = 1; i < count; ++i)
+    {
+        radius = std::min(radius, dot(normals[i], vertices[i]));
+    }
+    return radius;
+}
+
+uint32_t polygon::support(vector2f direction) const
+{
+    uint32_t best = 0;
+    float bestDistance = dot(vertices[0], direction);
+    for(uint32_t i = 1; i < count; ++i)
+    {
+        float distance = dot(vertices[i], direction);
+        if(distance > bestDistance)
+        {
+            best = i;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+} // namespace kq
@@ -0,0 +1,121 @@
+#include "profiler.h"
+#include <algorithm>
+
+namespace kq
+{
+
+profiler::profiler()
+    : m_enabled(false), m_mutex(), m_frameStart(), m_current(), m_history(), m_head(0), m_frames(0), m_bodies(0), m_pairs(0), m_contacts(0)
+{
+
+}
+
+void profiler::setEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    if(enabled && !m_enabled)
+    {
+        // Start over so the statistics do not mix in frames from before the pause.
+        m_head = 0;
+        m_frames = 0;
+        std::fill(std::begin(m_current), std::end(m_current), 0.f);
+    }
+    m_enabled = enabled;
+}
+
+void profiler::beginFrame()
+{
+    if(!m_enabled)
+        return;
+    std::lock_guard<std::mutex> guard(m_mutex);
+    std::fill(std::begin(m_current), std::end(m_current), 0.f);
+    m_frameStart = clock::now();
+}
+
+void profiler::endFrame()
+{
+    if(!m_enabled)
+        return;
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_current[static_cast<int>(profilePhase::Frame)] = std::chrono::duration<float, std::milli>(clock::now() - m_frameStart).count();
+    for(uint32_t phase = 0; phase < phaseCount; ++phase)
+    {
+        m_history[phase][m_head] = m_current[phase];
+    }
+    m_head = (m_head + 1) % historySize;
+    m_frames = std::min(m_frames + 1, historySize);
+}
+
+void profiler::add(profilePhase phase, float milliseconds)
+{
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_current[static_cast<int>(phase)] += milliseconds;
+}
+
+void profiler::setCounts(uint32_t bodies, uint32_t pairs, uint32_t contacts)
+{
+    m_bodies = bodies;
+    m_pairs = pairs;
+    m_contacts = contacts;
+}
+
+const float* profiler::getHistory(profilePhase phase) const { return m_history[static_cast<int>(phase)]; }
+
+// Until the buffer wraps the oldest frame is at 0, afterwards it is the next one to be overwritten.
+uint32_t profiler::getHistoryOffset() const { return m_frames < historySize ? 0 : m_head; }
+
+uint32_t profiler::getFrameCount() const { return m_frames; }
+
+float profiler::getAverage(profilePhase phase) const
+{
+    if(m_frames == 0)
+        return 0.f;
+    const float* history = getHistory(phase);
+    float sum = 0.f;
+    for(uint32_t i = 0; i < m_frames; ++i)
+    {
+        sum += history[i];
+    }
+    return sum / m_frames;
+}
+
+float profiler::getPercentile(profilePhase phase, float fraction) const
+{
+    if(m_frames == 0)
+        return 0.f;
+    float sorted[historySize];
+    std::copy(getHistory(phase), getHistory(phase) + m_frames, sorted);
+    uint32_t rank = std::min(static_cast<uint32_t>(fraction * m_frames), m_frames - 1);
+    std::nth_element(sorted, sorted + rank, sorted + m_frames);
+    return sorted[rank];
+}
+
+uint32_t profiler::getBodies() const { return m_bodies; }
+
+uint32_t profiler::getPairs() const { return m_pairs; }
+
+uint32_t profiler::getContacts() const { return m_contacts; }
+
+const char* profiler::getPhaseName(profilePhase phase)
+{
+    switch(phase)
+    {
+        case profilePhase::Frame: return "Frame";
+        case profilePhase::Events: return "Events";
+        case profilePhase::Update: return "Update";
+        case profilePhase::Integrate: return "  Integrate";
+        case profilePhase::Geometry: return "  Geometry";
+        case profilePhase::Broadphase: return "  Broadphase";
+        case profilePhase::TimeOfImpact: return "  Time of impact";
+        case profilePhase::Narrowphase: return "  Narrowphase";
+        case profilePhase::Resolve: return "  Resolve";
+        case profilePhase::Islands: return "  Islands";
+        case profilePhase::Draw: return "Draw";
+        case profilePhase::UI: return "UI";
+        case profilePhase::Render: return "ImGui render";
+        case profilePhase::Display: return "Display";
+        default: return "Unknown";
+    }
+}
+
+} // namespace kq
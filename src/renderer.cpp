@@ -0,0 +1,65 @@
+#include "renderer.h"
+#include <algorithm>
+
+namespace kq
+{
+
+static_assert(sizeof(vertex) == sizeof(sf::Vertex), "vertex must match the layout of sf::Vertex");
+
+renderer::renderer()
+    : m_bodies(), m_outlines()
+{
+
+}
+
+void renderer::draw(sf::RenderWindow& window, const world& world, const geometryCache& geometry,
+                    const std::vector<uint32_t>& candidates, float interpolation, threadPool& pool, bool hasSelection,
+                    uint32_t selected)
+{
+    const sf::View& view = window.getView();
+    vector2f center = fromSFML(view.getCenter());
+    vector2f size = fromSFML(view.getSize());
+    AABB visible = {center - size / 2.f, center + size / 2.f};
+    float unitsPerPixel = size.x / window.getSize().x;
+    float pointSize = pointPixels * unitsPerPixel;
+
+    // The world edges, so a world larger than the view can be found again.
+    sf::RectangleShape border(toSFML(world.getSize()));
+    border.setFillColor(sf::Color::Transparent);
+    border.setOutlineColor(sf::Color(90, 90, 90));
+    border.setOutlineThickness(unitsPerPixel);
+    window.draw(border);
+
+    m_bodies.fill(world, geometry, candidates, interpolation, pool, visible, pointSize);
+    submit(window, m_bodies.getVertices(), sf::Triangles);
+    submit(window, m_bodies.getPoints(), sf::Points);
+
+    // Sleeping bodies get a thin grey outline; points are too small to show one.
+    m_outlines.clear();
+    const std::vector<uint8_t>& asleep = world.getAsleep();
+    for(uint32_t i : candidates)
+    {
+        if(!asleep[i])
+            continue;
+        AABB bounds = world.getBounds(i);
+        vector2f extent = bounds.max - bounds.min;
+        if(visible.overlaps(bounds) && std::max(extent.x, extent.y) >= pointSize)
+            m_outlines.addOutline(world, geometry, i, interpolation, unitsPerPixel, sleepingColor);
+    }
+    if(hasSelection && selected < world.size())
+    {
+        rgba color = world.getInfo()[selected].color;
+        rgba outlineColor(255 - color.r, 255 - color.g, 255 - color.b, color.a);
+        m_outlines.addOutline(world, geometry, selected, interpolation, 2.0f * unitsPerPixel, outlineColor);
+    }
+    submit(window, m_outlines.getVertices(), sf::Triangles);
+}
+
+void renderer::submit(sf::RenderWindow& window, const std::vector<vertex>& vertices, sf::PrimitiveType type)
+{
+    if(vertices.empty())
+        return;
+    window.draw(reinterpret_cast<const sf::Vertex*>(vertices.data()), vertices.size(), type);
+}
+
+} // namespace kq
@@ -0,0 +1,234 @@
+#include "sceneWriter.h"
+#include "snapshot.h"
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace kq
+{
+
+namespace
+{
+
+// Formatted rows are collected in a buffer of this size before each write.
+constexpr size_t csvBufferSize = 1 << 20;
+// Longest row: a convex body, ten numbers and its vertices, with their separators.
+constexpr size_t csvMaxRow = 1024;
+
+template<typename T>
+char* appendNumber(char* out, T value, char separator)
+{
+    out = std::to_chars(out, out + 32, value).ptr;
+    *out++ = separator;
+    return out;
+}
+
+} // namespace
+
+void bodyColumns::capture(const world& world)
+{
+    positions = world.getPositions();
+    velocities = world.getVelocities();
+    masses = world.getMasses();
+    types = world.getTypes();
+    extents = world.getExtents();
+    colors.resize(world.size());
+    polygons.clear();
+    for(uint32_t i = 0; i < world.size(); ++i)
+    {
+        colors[i] = world.getInfo()[i].color;
+        if(types[i] == objectType::Convex)
+            polygons.push_back(world.getPolygon(i));
+    }
+    worldSize = world.getSize();
+}
+
+uint32_t bodyColumns::size() const { return static_cast<uint32_t>(positions.size()); }
+
+sceneWriter::sceneWriter()
+    : m_thread(), m_bodies(), m_filename(), m_format(fileFormat::Csv), m_busy(false), m_failed(false), m_written(0)
+{
+
+}
+
+sceneWriter::~sceneWriter()
+{
+    wait();
+}
+
+bool sceneWriter::start(const world& world, const std::string& filename, fileFormat format)
+{
+    if(m_busy)
+        return false;
+    wait();
+
+    m_bodies.capture(world);
+    m_filename = filename;
+    m_format = format;
+    m_written = 0;
+    m_failed = false;
+    m_busy = true;
+    m_thread = std::thread([this]
+    {
+        bool written = m_format == fileFormat::Snapshot ? writeSnapshot(m_filename, m_bodies, &m_written)
+                                                        : writeCsv(m_filename, m_bodies, &m_written);
+        m_failed = !written;
+        m_busy = false;
+    });
+    return true;
+}
+
+void sceneWriter::wait()
+{
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+bool sceneWriter::isBusy() const { return m_busy; }
+
+float sceneWriter::getProgress() const
+{
+    uint32_t total = m_bodies.size();
+    return total == 0 ? 1.f : static_cast<float>(m_written.load(std::memory_order_relaxed)) / total;
+}
+
+bool sceneWriter::hasFailed() const { return m_failed; }
+
+const std::string& sceneWriter::getFilename() const { return m_filename; }
+
+bool sceneWriter::writeCsv(const std::string& filename, const bodyColumns& bodies, std::atomic<uint32_t>* progress)
+{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cout << "Failed to create file: " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<char> buffer(csvBufferSize + csvMaxRow);
+    const char header[] = "PositionX,PositionY,VelocityX,VelocityY,ColorR,ColorG,ColorB,Mass,Type,Extra1,Extra2\n";
+    char* out = buffer.data();
+    std::memcpy(out, header, sizeof(header) - 1);
+    out += sizeof(header) - 1;
+
+    const uint32_t count = bodies.size();
+    size_t convex = 0;
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        out = appendNumber(out, bodies.positions[i].x, ',');
+        out = appendNumber(out, bodies.positions[i].y, ',');
+        out = appendNumber(out, bodies.velocities[i].x, ',');
+        out = appendNumber(out, bodies.velocities[i].y, ',');
+        out = appendNumber(out, static_cast<int>(bodies.colors[i].r), ',');
+        out = appendNumber(out, static_cast<int>(bodies.colors[i].g), ',');
+        out = appendNumber(out, static_cast<int>(bodies.colors[i].b), ',');
+        out = appendNumber(out, bodies.masses[i], ',');
+        out = appendNumber(out, static_cast<int>(bodies.types[i]), ',');
+        // Rectangles store width and height, convex bodies their vertices and the other shapes a
+        // single radius or side length.
+        if(bodies.types[i] == objectType::Convex)
+        {
+            const polygon& shape = bodies.polygons[convex++];
+            out = appendNumber(out, shape.count, ',');
+            for(uint32_t vertex = 0; vertex < shape.count; ++vertex)
+            {
+                out = appendNumber(out, shape.vertices[vertex].x, ',');
+                out = appendNumber(out, shape.vertices[vertex].y, vertex + 1 < shape.count ? ',' : '\n');
+            }
+        }
+        else
+        {
+            if(bodies.types[i] == objectType::Rectangle)
+                out = appendNumber(out, bodies.extents[i].x, ',');
+            out = appendNumber(out, bodies.types[i] == objectType::Rectangle ? bodies.extents[i].y : bodies.extents[i].x, '\n');
+        }
+
+        if(static_cast<size_t>(out - buffer.data()) >= csvBufferSize)
+        {
+            file.write(buffer.data(), out - buffer.data());
+            out = buffer.data();
+            if(progress != nullptr)
+                progress->store(i + 1, std::memory_order_relaxed);
+        }
+    }
+    file.write(buffer.data(), out - buffer.data());
+    if(progress != nullptr)
+        progress->store(count, std::memory_order_relaxed);
+
+    if(!file)
+    {
+        std::cout << "Failed to write file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool sceneWriter::writeSnapshot(const std::string& filename, const bodyColumns& bodies, std::atomic<uint32_t>* progress)
+{
+    std::ofstream file(filename, std::ios::binary);
+    if(!file.is_open())
+    {
+        std::cout << "Failed to create file: " << filename << std::endl;
+        return false;
+    }
+
+    const uint32_t count = bodies.size();
+    struct columnData
+    {
+        snapshot::column id;
+        uint32_t elementSize;
+        const void* data;
+        uint64_t count;
+    };
+    const columnData columns[] = {
+        {snapshot::column::Positions, sizeof(vector2f), bodies.positions.data(), count},
+        {snapshot::column::Velocities, sizeof(vector2f), bodies.velocities.data(), count},
+        {snapshot::column::Masses, sizeof(float), bodies.masses.data(), count},
+        {snapshot::column::Types, sizeof(objectType), bodies.types.data(), count},
+        {snapshot::column::Extents, sizeof(vector2f), bodies.extents.data(), count},
+        {snapshot::column::Colors, sizeof(rgba), bodies.colors.data(), count},
+        {snapshot::column::Polygons, sizeof(polygon), bodies.polygons.data(), bodies.polygons.size()},
+    };
+    const uint32_t columnCount = sizeof(columns) / sizeof(columns[0]);
+
+    auto align = [](uint64_t offset) { return (offset + snapshot::alignment - 1) / snapshot::alignment * snapshot::alignment; };
+
+    snapshot::header header = {};
+    std::memcpy(header.magic, snapshot::magic, sizeof(header.magic));
+    header.version = snapshot::version;
+    header.byteOrder = snapshot::byteOrder;
+    header.bodyCount = count;
+    header.worldSize = bodies.worldSize;
+    header.columnCount = columnCount;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    uint64_t offset = align(sizeof(header) + columnCount * sizeof(snapshot::columnEntry));
+    for(const columnData& column : columns)
+    {
+        snapshot::columnEntry entry = {static_cast<uint32_t>(column.id), column.elementSize, offset};
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        offset = align(offset + column.count * column.elementSize);
+    }
+
+    const char padding[snapshot::alignment] = {};
+    uint64_t written = sizeof(header) + columnCount * sizeof(snapshot::columnEntry);
+    for(uint32_t i = 0; i < columnCount; ++i)
+    {
+        file.write(padding, align(written) - written);
+        uint64_t bytes = columns[i].count * columns[i].elementSize;
+        file.write(static_cast<const char*>(columns[i].data), bytes);
+        written = align(written) + bytes;
+        if(progress != nullptr)
+            progress->store(static_cast<uint32_t>(static_cast<uint64_t>(count) * (i + 1) / columnCount), std::memory_order_relaxed);
+    }
+
+    if(!file)
+    {
+        std::cout << "Failed to write file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace kq
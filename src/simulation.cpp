@@ -0,0 +1,293 @@
+#include "simulation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace kq
+{
+
+simulation::simulation()
+    : m_world(), m_pool(), m_entities(), m_fileManager(this), m_geometry(), m_collider(), m_continuous(),
+    m_threadPool(threadPool::getHardwareThreads()), m_solver(), m_islands(), m_profiler(),
+    m_stepSize(1.f / 120.f), m_maxSubsteps(8), m_accumulator(0.f), m_stepCount(0), m_interpolation(1.f)
+{
+
+}
+
+simulation::~simulation()
+{
+    clearEntities();
+}
+
+void simulation::advance(float frameTime)
+{
+    // Time acceleration banks more simulated time per frame, so it runs extra steps instead of
+    // stretching one, and the substep budget grows with it.
+    float acceleration = physicalObject::m_timeAcceleration;
+    uint32_t maxSteps = static_cast<uint32_t>(m_maxSubsteps * std::max(1.f, std::ceil(acceleration)));
+    m_stepCount = 0;
+    m_accumulator += frameTime * acceleration;
+    while(m_accumulator >= m_stepSize && m_stepCount < maxSteps)
+    {
+        step(m_stepSize);
+        m_accumulator -= m_stepSize;
+        ++m_stepCount;
+    }
+
+    // Drop the time that could not be caught up on instead of spiralling on the next frame.
+    if(m_accumulator >= m_stepSize)
+        m_accumulator = std::fmod(m_accumulator, m_stepSize);
+    m_interpolation = m_accumulator / m_stepSize;
+}
+
+void simulation::step(float deltaTime)
+{
+    for(profilePhase phase : stepPhases)
+    {
+        profiler::scope timer(m_profiler, phase);
+        runPhase(phase, deltaTime);
+    }
+
+    m_profiler.setCounts(m_world.size(), static_cast<uint32_t>(m_collider.getPairs().size()),
+                         static_cast<uint32_t>(m_collider.getContacts().size()));
+}
+
+void simulation::runPhase(profilePhase phase, float deltaTime)
+{
+    // Brute force has no separate broadphase, its whole pass counts as narrowphase.
+    bool bruteForce = m_collider.getBroadphase() == broadphaseType::BruteForce;
+    switch(phase)
+    {
+        case profilePhase::Integrate:
+            m_threadPool.parallelFor(m_world.size(), 1024, [&](uint32_t begin, uint32_t end)
+            {
+                m_world.integrate(deltaTime, begin, end);
+            });
+            break;
+        case profilePhase::Geometry:
+            updateGeometry();
+            break;
+        case profilePhase::Broadphase:
+            if(!bruteForce)
+                m_collider.findPairs(m_world, m_geometry);
+            break;
+        case profilePhase::TimeOfImpact:
+            if(bruteForce)
+                m_continuous.solveAll(m_world);
+            else
+                m_continuous.solve(m_world, m_collider.getPairs());
+            m_geometry.refresh(m_world, m_continuous.getRewound());
+            break;
+        case profilePhase::Narrowphase:
+            if(bruteForce)
+                m_collider.findContacts(m_world, m_geometry);
+            else
+                m_collider.testPairs(m_world, m_geometry);
+            break;
+        case profilePhase::Resolve:
+            m_solver.solve(m_world, m_collider.getContacts(), m_threadPool, deltaTime);
+            break;
+        case profilePhase::Islands:
+            m_islands.update(m_world, m_collider.getContacts(), deltaTime);
+            break;
+        default:
+            break;
+    }
+}
+
+void simulation::hold()
+{
+    m_accumulator = 0.f;
+    m_stepCount = 0;
+    m_interpolation = 1.f;
+}
+
+const std::vector<physicalObject*>& simulation::getEntities() const
+{
+    return m_entities;
+}
+
+std::vector<physicalObject*>& simulation::getEntities()
+{
+    return m_entities;
+}
+
+world& simulation::getWorld()
+{
+    return m_world;
+}
+
+const world& simulation::getWorld() const
+{
+    return m_world;
+}
+
+fileManager& simulation::getFileManager()
+{
+    return m_fileManager;
+}
+
+const geometryCache& simulation::getGeometry()
+{
+    // Bodies added or removed since the last step.
+    if(m_geometry.getRevision() != m_world.getRevision())
+        updateGeometry();
+    return m_geometry;
+}
+
+void simulation::updateGeometry()
+{
+    m_geometry.update(m_world, m_threadPool);
+}
+
+collider& simulation::getCollider()
+{
+    return m_collider;
+}
+
+continuousCollider& simulation::getContinuousCollider()
+{
+    return m_continuous;
+}
+
+threadPool& simulation::getThreadPool()
+{
+    return m_threadPool;
+}
+
+contactSolver& simulation::getSolver()
+{
+    return m_solver;
+}
+
+islandManager& simulation::getIslands()
+{
+    return m_islands;
+}
+
+profiler& simulation::getProfiler()
+{
+    return m_profiler;
+}
+
+float& simulation::getStepSize()
+{
+    return m_stepSize;
+}
+
+int& simulation::getMaxSubsteps()
+{
+    return m_maxSubsteps;
+}
+
+uint32_t simulation::getStepCount() const
+{
+    return m_stepCount;
+}
+
+float simulation::getInterpolation() const
+{
+    return m_interpolation;
+}
+
+bool simulation::removeObject(bodyHandle handle)
+{
+    uint32_t index = m_world.getIndex(handle);
+    if(index == world::invalidIndex)
+        return false;
+
+    uint32_t last = m_world.size() - 1;
+    m_pool.destroy(m_entities[index]);
+    if(index != last)
+    {
+        m_entities[index] = m_entities[last];
+        m_entities[index]->setIndex(index);
+    }
+    m_entities.pop_back();
+    m_world.remove(index);
+    return true;
+}
+
+void simulation::clearEntities()
+{
+    for(physicalObject* entity : m_entities)
+    {
+        entity->~physicalObject();
+    }
+    m_pool.reset();
+    m_entities.clear();
+    m_world.clear();
+    m_solver.clear();
+}
+
+void simulation::Impulse()
+{
+    for(auto& entity : m_entities)
+    {
+        vector2f random = {static_cast<float>(rand() % 350 + 100) * entity->getMass() / 2,
+                            static_cast<float>(rand() % 350 + 100) * entity->getMass() / 2};
+        entity->applyForce(random);
+    }
+}
+
+void simulation::createEntities(uint32_t first)
+{
+    const std::vector<objectType>& types = m_world.getTypes();
+    m_entities.reserve(m_world.size());
+    for(uint32_t i = first; i < m_world.size(); ++i)
+    {
+        switch(types[i])
+        {
+            case objectType::Circle:
+                m_entities.push_back(m_pool.create<Circle>(m_world, i));
+                break;
+            case objectType::Square:
+                m_entities.push_back(m_pool.create<Square>(m_world, i));
+                break;
+            case objectType::Rectangle:
+                m_entities.push_back(m_pool.create<Rectangle>(m_world, i));
+                break;
+            case objectType::Triangle:
+                m_entities.push_back(m_pool.create<Triangle>(m_world, i));
+                break;
+            case objectType::Convex:
+                m_entities.push_back(m_pool.create<Convex>(m_world, i));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+physicalObject* simulation::createObject(objectType type, vector2f position, vector2f velocity, rgba color, float mass,
+                                         float radius, vector2f size)
+{
+    physicalObjectArgs args(position, velocity, color, mass, type);
+    switch(type)
+    {
+        case objectType::Circle:
+            m_entities.push_back(m_pool.create<Circle>(m_world, std::move(args), radius));
+            break;
+        case objectType::Square:
+            m_entities.push_back(m_pool.create<Square>(m_world, std::move(args), radius));
+            break;
+        case objectType::Rectangle:
+            m_entities.push_back(m_pool.create<Rectangle>(m_world, std::move(args), size.x, size.y));
+            break;
+        case objectType::Triangle:
+            m_entities.push_back(m_pool.create<Triangle>(m_world, std::move(args), radius));
+            break;
+        default:
+            return nullptr;
+    }
+    return m_entities.back();
+}
+
+physicalObject* simulation::createObject(vector2f position, vector2f velocity, rgba color, float mass, const polygon& shape)
+{
+    physicalObjectArgs args(position, velocity, color, mass, objectType::Convex);
+    m_entities.push_back(m_pool.create<Convex>(m_world, std::move(args), shape));
+    return m_entities.back();
+}
+
+} // namespace kq
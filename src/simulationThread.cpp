@@ -0,0 +1,198 @@
+#include "simulationThread.h"
+#include <algorithm>
+
+namespace kq
+{
+
+float simulationState::getInterpolation(clock::time_point now) const
+{
+    if(!playing || stepDuration <= 0)
+        return interpolation;
+    float elapsed = std::chrono::duration<float>(now - published).count();
+    return std::min(interpolation + elapsed / stepDuration, 1.f);
+}
+
+simulationThread::simulationThread(simulation& simulation)
+    : m_simulation(simulation), m_thread(), m_mutex(), m_wake(), m_commands(), m_running(false), m_playing(false),
+    m_region(), m_viewChanged(false), m_states()
+{
+
+}
+
+simulationThread::~simulationThread()
+{
+    stop();
+}
+
+void simulationThread::start()
+{
+    if(m_thread.joinable())
+        return;
+    // Published here so the first frame already sees the scene.
+    publish(simulationState::clock::now(), false, m_region);
+    m_viewChanged = false;
+    m_running = true;
+    m_thread = std::thread(&simulationThread::run, this);
+}
+
+void simulationThread::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+void simulationThread::post(command command)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_commands.push_back(std::move(command));
+    }
+    m_wake.notify_all();
+}
+
+void simulationThread::setPlaying(bool playing)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_playing == playing)
+            return;
+        m_playing = playing;
+    }
+    m_wake.notify_all();
+}
+
+void simulationThread::setView(const AABB& view)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Republished once the view has moved a quarter of its size or was zoomed far enough
+        // that the region no longer fits it.
+        vector2f size = view.max - view.min;
+        vector2f regionSize = m_region.max - m_region.min;
+        AABB inner = {m_region.min + size / 4.f, m_region.max - size / 4.f};
+        if(inner.contains(view) && regionSize.x <= 4.f * size.x && regionSize.y <= 4.f * size.y)
+            return;
+        m_region = {view.min - size / 2.f, view.max + size / 2.f};
+        m_viewChanged = true;
+    }
+    m_wake.notify_all();
+}
+
+const simulationState& simulationThread::getState()
+{
+    m_states.update();
+    return m_states.getFront();
+}
+
+void simulationThread::run()
+{
+    using clock = simulationState::clock;
+    clock::time_point last = clock::now();
+    clock::time_point due = last;
+    bool wasPlaying = false;
+    std::vector<command> commands;
+    while(true)
+    {
+        bool playing;
+        bool viewChanged;
+        AABB region;
+        {
+            // Paused, only commands and the view wake the thread; playing, also the next step
+            // falling due.
+            std::unique_lock<std::mutex> lock(m_mutex);
+            auto ready = [&] { return !m_running || !m_commands.empty() || m_playing != wasPlaying || m_viewChanged; };
+            if(m_playing)
+                m_wake.wait_until(lock, due, ready);
+            else
+                m_wake.wait(lock, ready);
+            if(!m_running)
+                return;
+            commands.swap(m_commands);
+            playing = m_playing;
+            viewChanged = m_viewChanged;
+            m_viewChanged = false;
+            region = m_region;
+        }
+
+        for(command& command : commands)
+        {
+            command(m_simulation);
+        }
+        bool changed = !commands.empty() || viewChanged;
+        commands.clear();
+
+        clock::time_point now = clock::now();
+        // Time spent paused is not caught up on.
+        float elapsed = wasPlaying ? std::chrono::duration<float>(now - last).count() : 0.f;
+        last = now;
+        if(playing)
+            m_simulation.advance(elapsed);
+        else if(wasPlaying)
+            m_simulation.hold();
+        if(changed || playing || wasPlaying)
+            publish(now, playing, region);
+        wasPlaying = playing;
+
+        // The accumulator covers the next step once the rest of it has passed.
+        float acceleration = std::max(physicalObject::m_timeAcceleration, 1e-3f);
+        float wait = (1.f - m_simulation.getInterpolation()) * m_simulation.getStepSize() / acceleration;
+        due = now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(wait));
+    }
+}
+
+void simulationThread::publish(simulationState::clock::time_point now, bool playing, const AABB& region)
+{
+    simulationState& state = m_states.getBack();
+    state.bodies = m_simulation.getWorld();
+    state.geometry = m_simulation.getGeometry();
+
+    collider& collision = m_simulation.getCollider();
+    contactSolver& solver = m_simulation.getSolver();
+    continuousCollider& continuous = m_simulation.getContinuousCollider();
+    islandManager& islands = m_simulation.getIslands();
+    state.contacts = collision.getContacts();
+    state.visible.clear();
+    collision.queryRegion(m_simulation.getWorld(), region, state.visible);
+    // Drawn in index order, so later bodies stay on top.
+    std::sort(state.visible.begin(), state.visible.end());
+
+    simulationSettings& settings = state.settings;
+    settings.stepSize = m_simulation.getStepSize();
+    settings.maxSubsteps = m_simulation.getMaxSubsteps();
+    settings.threads = m_simulation.getThreadPool().getThreadCount();
+    settings.broadphase = collision.getBroadphase();
+    settings.cellSize = collision.getCellSize();
+    settings.treeMargin = collision.getTreeMargin();
+    settings.batchedCircles = collision.getBatchedCircles();
+    settings.solverIterations = solver.getIterations();
+    settings.warmStarting = solver.getWarmStarting();
+    settings.continuous = continuous.getEnabled();
+    settings.sleeping = islands.getEnabled();
+    settings.sleepSpeed = islands.getSleepSpeed();
+    settings.sleepTime = islands.getSleepTime();
+    settings.gravity = physicalObject::m_gravity;
+    settings.airResistance = physicalObject::m_airResistance;
+    settings.timeAcceleration = physicalObject::m_timeAcceleration;
+
+    state.stepCount = m_simulation.getStepCount();
+    state.pairCount = static_cast<uint32_t>(collision.getPairs().size());
+    state.colorCount = solver.getColorCount();
+    state.manifoldCount = static_cast<uint32_t>(solver.getManifoldCount());
+    state.treeHeight = collision.getTreeHeight();
+    state.fastCount = continuous.getFastCount();
+    state.impactCount = continuous.getImpactCount();
+    state.sleepingCount = islands.getSleepingCount();
+
+    state.interpolation = m_simulation.getInterpolation();
+    state.stepDuration = m_simulation.getStepSize() / std::max(physicalObject::m_timeAcceleration, 1e-3f);
+    state.published = now;
+    state.playing = playing;
+    m_states.publish();
+}
+
+} // namespace kq
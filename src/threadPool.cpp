@@ -0,0 +1,126 @@
+#include "threadPool.h"
+#include <algorithm>
+
+namespace kq
+{
+
+threadPool::threadPool(uint32_t threadCount)
+    : m_workers(), m_mutex(), m_wake(), m_done(), m_stop(false), m_generation(0), m_pending(0),
+    m_job(nullptr), m_count(0), m_chunkSize(0), m_chunkCount(0), m_nextChunk(0)
+{
+    start(threadCount);
+}
+
+threadPool::~threadPool()
+{
+    stop();
+}
+
+void threadPool::setThreadCount(uint32_t threadCount)
+{
+    if(std::max(threadCount, 1u) == getThreadCount())
+        return;
+    stop();
+    start(threadCount);
+}
+
+uint32_t threadPool::getThreadCount() const
+{
+    return static_cast<uint32_t>(m_workers.size()) + 1;
+}
+
+uint32_t threadPool::getHardwareThreads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+void threadPool::parallelFor(uint32_t count, uint32_t minChunk, const std::function<void(uint32_t, uint32_t)>& job)
+{
+    if(count == 0)
+        return;
+
+    // A few chunks per thread lets fast threads pick up the slack of slow ones.
+    uint32_t chunkCount = std::min(getThreadCount() * 4, (count + minChunk - 1) / std::max(minChunk, 1u));
+    if(m_workers.empty() || chunkCount <= 1)
+    {
+        job(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = count;
+        m_chunkSize = (count + chunkCount - 1) / chunkCount;
+        m_chunkCount = (count + m_chunkSize - 1) / m_chunkSize;
+        m_nextChunk.store(0);
+        m_pending = static_cast<uint32_t>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runChunks();
+
+    // Every worker has to finish this generation, not only the ones that woke in time: a worker
+    // still on its way into runChunks would otherwise read the next loop's fields with this one's.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    m_job = nullptr;
+}
+
+void threadPool::start(uint32_t threadCount)
+{
+    m_stop = false;
+    for(uint32_t i = 1; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&threadPool::workerLoop, this, m_generation);
+    }
+}
+
+void threadPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for(std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+void threadPool::workerLoop(uint64_t seen)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+        if(m_stop)
+            return;
+        seen = m_generation;
+        lock.unlock();
+
+        runChunks();
+
+        lock.lock();
+        if(--m_pending == 0)
+            m_done.notify_all();
+    }
+}
+
+void threadPool::runChunks()
+{
+    while(true)
+    {
+        uint32_t chunk = m_nextChunk.fetch_add(1);
+        if(chunk >= m_chunkCount)
+            return;
+        uint32_t begin = chunk * m_chunkSize;
+        uint32_t end = std::min(begin + m_chunkSize, m_count);
+        (*m_job)(begin, end);
+    }
+}
+
+} // namespace kq
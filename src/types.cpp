@@ -1,403 +1,162 @@
 #include "types.h"
+#include "narrowphase.h"
 #include <array>
+#include <cmath>
 #include <string>
 #include <sstream>
 
 namespace kq
 {
 
-physicalObjectArgs::physicalObjectArgs(const sf::Vector2f& position, const sf::Vector2f& velocity,
-									const sf::Color& color, float mass, objectType type)
+physicalObjectArgs::physicalObjectArgs(const vector2f& position, const vector2f& velocity,
+									const rgba& color, float mass, objectType type)
 	: position(position), velocity(velocity), color(color), mass(mass), type(type) {}
 
-physicalObject::physicalObject(physicalObjectArgs&& args)
-        : m_position(args.position), m_velocity(args.velocity), m_color(args.color),
-          m_mass(args.mass), m_type(args.type), m_collisions(0) {}
-
-sf::Vector2f& physicalObject::getPosition() { return m_position; }
-sf::Vector2f& physicalObject::getVelocity() { return m_velocity; }
-sf::Color& physicalObject::getColor() { return m_color; }
-float& physicalObject::getMass() { return m_mass; }
-objectType& physicalObject::getObjectType() { return m_type; }
-
-sf::Vector2f physicalObject::getPosition() const { return m_position; }
-sf::Vector2f physicalObject::getVelocity() const { return m_velocity; }
-sf::Color physicalObject::getColor() const { return m_color; }
-float physicalObject::getMass() const { return m_mass; }
-float physicalObject::getInvMass() const { return 1 / m_mass; }
-objectType physicalObject::getObjectType() const { return m_type; }
-uint32_t physicalObject::getCollisions() const { return m_collisions; }
-
-void physicalObject::applyGravity(float deltaTime)
+physicalObject::physicalObject(world& world, physicalObjectArgs&& args, vector2f extents)
+        : m_world(&world), m_index(world.add(args, extents)) {}
+
+physicalObject::physicalObject(world& world, physicalObjectArgs&& args, const polygon& shape)
+        : m_world(&world), m_index(world.add(args, shape)) {}
+
+physicalObject::physicalObject(world& world, uint32_t index)
+        : m_world(&world), m_index(index) {}
+
+vector2f& physicalObject::getPosition() { return m_world->getPositions()[m_index]; }
+vector2f& physicalObject::getVelocity() { return m_world->getVelocities()[m_index]; }
+rgba& physicalObject::getColor() { return m_world->getInfo()[m_index].color; }
+
+vector2f physicalObject::getPosition() const { return m_world->getPositions()[m_index]; }
+vector2f physicalObject::getVelocity() const { return m_world->getVelocities()[m_index]; }
+rgba physicalObject::getColor() const { return m_world->getInfo()[m_index].color; }
+float physicalObject::getMass() const { return m_world->getMasses()[m_index]; }
+float physicalObject::getInvMass() const { return m_world->getInvMasses()[m_index]; }
+objectType physicalObject::getObjectType() const { return m_world->getTypes()[m_index]; }
+uint32_t physicalObject::getCollisions() const { return m_world->getInfo()[m_index].collisions; }
+AABB physicalObject::getBounds() const { return m_world->getBounds(m_index); }
+uint32_t physicalObject::getIndex() const { return m_index; }
+bodyHandle physicalObject::getHandle() const { return m_world->getHandle(m_index); }
+void physicalObject::setIndex(uint32_t index) { m_index = index; }
+vector2f physicalObject::getExtents() const { return m_world->getExtents()[m_index]; }
+
+void physicalObject::setMass(float mass)
+{
+	m_world->setMass(m_index, mass);
+}
+
+void physicalObject::applyForce(const vector2f& force)
 {
-	m_velocity += sf::Vector2f{0, m_gravity * m_mass} * deltaTime;
+	getVelocity() += force * getInvMass();
+	m_world->wake(m_index);
 }
 
-void physicalObject::applyAirResistance(float deltaTime)
+bool physicalObject::collidesWith(const physicalObject& other) const
 {
-	float relativeAirResistance = 1.0f - (m_airResistance * deltaTime) / m_mass;
-	m_velocity *= relativeAirResistance;
+	return narrowphase::collide(*this, other);
 }
 
-float physicalObject::dotProduct(const sf::Vector2f& a, const sf::Vector2f& b)
+float physicalObject::dotProduct(const vector2f& a, const vector2f& b)
 {
     return a.x * b.x + a.y * b.y;
 }
 
-float physicalObject::crossProduct(const sf::Vector2f& a, const sf::Vector2f& b)
+float physicalObject::crossProduct(const vector2f& a, const vector2f& b)
 {
     return a.x * b.y - a.y * b.x;
 }
 
-sf::Vector2f physicalObject::normalize(const sf::Vector2f& vector)
+vector2f physicalObject::normalize(const vector2f& vector)
 {
     float length = std::sqrt(vector.x * vector.x + vector.y * vector.y);
     if (length != 0) {
-        return sf::Vector2f(vector.x / length, vector.y / length);
+        return vector2f(vector.x / length, vector.y / length);
     } else {
         return vector;
     }
 }
 
-void physicalObject::resolveCollision(physicalObject& obj1, physicalObject& obj2)
-{
-	++obj1.m_collisions;
-	 // Calculate the direction of the collision
-    sf::Vector2f collisionDir = obj1.getPosition() - obj2.getPosition();
-    collisionDir = normalize(collisionDir);
-
-    // Calculate the relative velocity
-    sf::Vector2f relVel = obj1.getVelocity() - obj2.getVelocity();
-
-    // Calculate the velocity along the direction of the collision
-    float velAlongCollision = dotProduct(relVel, collisionDir);
-
-    // If the objects are moving away from each other, do nothing
-    if(velAlongCollision > 0)
-        return;
-
-	// Calculate the impulse
-    float impulse = -(1 + restitution) * velAlongCollision / (obj1.getInvMass() + obj2.getInvMass());
-    sf::Vector2f impulseVec = impulse * collisionDir;
-
-    // Apply the impulse to the objects
-    sf::Vector2f impulseVecScaled1 = sf::Vector2f(impulseVec.x * obj1.getInvMass(), impulseVec.y * obj1.getInvMass());
-	obj1.getVelocity() = obj1.getVelocity() + impulseVecScaled1;
-
-	sf::Vector2f impulseVecScaled2 = sf::Vector2f(impulseVec.x * obj2.getInvMass(), impulseVec.y * obj2.getInvMass());
-	obj2.getVelocity() = obj2.getVelocity() - impulseVecScaled2;
-
-    
-}
-
 float physicalObject::restitution = 0.8f;
-bool physicalObject::m_outline = false;
 float physicalObject::m_gravity = 9.8f;
 float physicalObject::m_airResistance = 0.01f;
 float physicalObject::m_timeAcceleration = 1.f;
 
 /* ========== Circle ========== */
 
-Circle::Circle(physicalObjectArgs&& args, float radius)
-	: physicalObject(std::move(args)), m_radius(radius) {}
+Circle::Circle(world& world, physicalObjectArgs&& args, float radius)
+	: physicalObject(world, std::move(args), {radius, radius}) {}
 
-void Circle::move(const sf::Vector2f& offset, float deltaTime)  
-{
-	m_position += offset * deltaTime;
-    if (m_position.x - m_radius < 0) {
-        m_position.x = m_radius;
-        m_velocity.x *= -1; 
-    } else if (m_position.x + m_radius > SCREEN_WIDTH_F) {
-        m_position.x = SCREEN_WIDTH_F - m_radius;
-        m_velocity.x *= -1; 
-    }
-
-    if (m_position.y - m_radius < 0) {
-        m_position.y = m_radius;
-        m_velocity.y *= -1; 
-    } else if (m_position.y + m_radius > SCREEN_LENGTH_F) {
-        m_position.y = SCREEN_LENGTH_F - m_radius;
-        m_velocity.y *= -1; 
-    }
-}
-
-void Circle::applyForce(const sf::Vector2f& force)  
-{
-	m_velocity += force / static_cast<float>(m_mass);
-}
-
-void Circle::update(float deltaTime)  
-{
-	// Update position based on velocity.
-	deltaTime *= m_timeAcceleration;
-	applyGravity(deltaTime);
-	applyAirResistance(deltaTime);
-	move(m_velocity, deltaTime);
-}
-
-void Circle::draw(sf::RenderWindow& window) const  
-{
-	sf::CircleShape circle(m_radius);
-	circle.setOrigin(m_radius, m_radius);
-	circle.setFillColor(m_color);
-	if(physicalObject::m_outline)
-	{
-		sf::Color outlineColor = sf::Color{static_cast<sf::Uint8>(255 - m_color.r), static_cast<sf::Uint8>(255 - m_color.g),
-		 static_cast<sf::Uint8>(255 - m_color.b), m_color.a};
-		circle.setOutlineColor(outlineColor);
-		circle.setOutlineThickness(2.0f);
-	}
-	circle.setPosition(m_position);
-	window.draw(circle);
-}
+Circle::Circle(world& world, uint32_t index)
+	: physicalObject(world, index) {}
 
 objectType Circle::getType() const  
 {
 	return objectType::Circle;
 }
 
-bool Circle::collidesWith(const physicalObject& other) const  
-{
-	if (const Circle* circle = dynamic_cast<const Circle*>(&other)) 
-	{
-		return collidesWith(*circle);
-	} 
-	else if (const Square* square = dynamic_cast<const Square*>(&other)) 
-	{
-		return collidesWith(*square);
-	}
-	else if(const Triangle* triangle = dynamic_cast<const Triangle*>(&other))
-	{
-		return collidesWith(*triangle);
-	}
-	else if(const Rectangle* rectangle = dynamic_cast<const Rectangle*>(&other))
-	{
-		return collidesWith(*rectangle);
-	}
-	else return false;
-}
+float Circle::getRadius() const { return getExtents().x; }
 
-bool Circle::collidesWith(const Circle& other) const 
+bool Circle::containsPoint(vector2f point) const
 {
-	float distance = sqrt(pow(m_position.x - other.m_position.x, 2) + pow(m_position.y - other.m_position.y, 2));
-	return distance < (m_radius + other.m_radius);
-}
+    vector2f position = getPosition();
 
-bool Circle::collidesWith(const Square& other) const 
-{
-    std::array<sf::Vector2f, 4> corners = other.getVertices();
+    float distanceX = position.x - point.x;
+    float distanceY = position.y - point.y;
 
-    for (const auto& corner : corners) 
-    {
-        if (containsPoint(corner))
-        {
-            return true;  
-        }
-    }
-    return false;
-}
-
-bool Circle::collidesWith(const Triangle& other) const
-{
-	
-    for (const auto& vertex : other.getVertices())
-    {
-        if (containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    return false;
-}
-
-bool Circle::collidesWith(const Rectangle& other) const 
-{
-    auto vertices = other.getVertices();
-
-    for (const auto& vertex : vertices)
-    {
-        if (containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    return false;
-}
-
-bool Circle::containsPoint(sf::Vector2f point) const
-{
-    float distanceX = m_position.x - point.x;
-    float distanceY = m_position.y - point.y;
-
-    return (distanceX * distanceX + distanceY * distanceY) <= (m_radius * m_radius);
+    return (distanceX * distanceX + distanceY * distanceY) <= (getRadius() * getRadius());
 }
 
 std::string Circle::toCSVString() const
 {
+    vector2f position = getPosition();
+    vector2f velocity = getVelocity();
+    rgba color = getColor();
+
     std::ostringstream ss;
-    ss << m_position.x << "," << m_position.y << ","
-       << m_velocity.x << "," << m_velocity.y << ","
-       << static_cast<int>(m_color.r) << "," << static_cast<int>(m_color.g) << "," << static_cast<int>(m_color.b) << ","
-       << m_mass << ","
-       << static_cast<int>(m_type) << "," << m_radius;
+    ss << position.x << "," << position.y << ","
+       << velocity.x << "," << velocity.y << ","
+       << static_cast<int>(color.r) << "," << static_cast<int>(color.g) << "," << static_cast<int>(color.b) << ","
+       << getMass() << ","
+       << static_cast<int>(getObjectType()) << "," << getRadius();
     return ss.str();
 }
 
 /* ========== Square ========== */
 
-Square::Square(physicalObjectArgs&& args, float sideLength)
-	: physicalObject(std::move(args)), m_sideLength(sideLength) {}
-
-void Square::move(const sf::Vector2f& offset, float deltaTime) 
-{
-	m_position += offset * deltaTime;
-	float halfSideLength = m_sideLength / 2;
-
-	if (m_position.x - halfSideLength < 0) {
-		m_position.x = halfSideLength;
-		m_velocity.x *= -1; 
-	} else if (m_position.x + halfSideLength > SCREEN_WIDTH_F) {
-		m_position.x = SCREEN_WIDTH_F - halfSideLength;
-		m_velocity.x *= -1; 
-	}
-
-	if (m_position.y - halfSideLength < 0) {
-		m_position.y = halfSideLength;
-		m_velocity.y *= -1; 
-	} else if (m_position.y + halfSideLength > SCREEN_LENGTH_F) {
-		m_position.y = SCREEN_LENGTH_F - halfSideLength;
-		m_velocity.y *= -1; 
-	}
-}
+Square::Square(world& world, physicalObjectArgs&& args, float sideLength)
+	: physicalObject(world, std::move(args), {sideLength, sideLength}) {}
 
-void Square::applyForce(const sf::Vector2f& force) 
-{
-	m_velocity += force / static_cast<float>(m_mass);
-}
-
-void Square::update(float deltaTime) 
-{
-	deltaTime *= m_timeAcceleration;
-	applyGravity(deltaTime);
-	applyAirResistance(deltaTime);
-	move(m_velocity, deltaTime);
-}
-
-void Square::draw(sf::RenderWindow& window) const 
-{
-	sf::RectangleShape square(sf::Vector2f(m_sideLength, m_sideLength));
-	square.setOrigin(m_sideLength / 2, m_sideLength / 2);
-	square.setFillColor(m_color);
-	if(physicalObject::m_outline)
-	{
-		sf::Color outlineColor = sf::Color{static_cast<sf::Uint8>(255 - m_color.r), static_cast<sf::Uint8>(255 - m_color.g),
-		 static_cast<sf::Uint8>(255 - m_color.b), m_color.a};
-		square.setOutlineColor(outlineColor);
-		square.setOutlineThickness(2.0f);
-	}
-	square.setPosition(m_position);
-	window.draw(square);
-}
+Square::Square(world& world, uint32_t index)
+	: physicalObject(world, index) {}
 
 objectType Square::getType() const 
 {
 	return objectType::Square;
 }
 
-bool Square::collidesWith(const physicalObject& other) const
-{
-	if (const Circle* circle = dynamic_cast<const Circle*>(&other)) 
-	{
-		return collidesWith(*circle);
-	} 
-	else if (const Square* square = dynamic_cast<const Square*>(&other)) 
-	{
-		return collidesWith(*square);
-	}
-	else if(const Triangle* triangle = dynamic_cast<const Triangle*>(&other))
-	{
-		return collidesWith(*triangle);
-	}
-	else if(const Rectangle* rectangle = dynamic_cast<const Rectangle*>(&other))
-	{
-		return collidesWith(*rectangle);
-	}
-	else return false;
-}
-
-bool Square::collidesWith(const Circle& other) const
-{
-	return other.collidesWith(*this);
-}
-
-bool Square::collidesWith(const Square& other) const
-{
-	
-	if (other.getPosition().x < m_position.x && m_position.x < other.getPosition().x + other.getSideLength() ||
-		other.getPosition().x < m_position.x + m_sideLength && m_position.x + m_sideLength < other.getPosition().x + other.getSideLength()) 
-	{
-		
-		if (other.getPosition().y < m_position.y && m_position.y < other.getPosition().y + other.getSideLength() ||
-			other.getPosition().y < m_position.y + m_sideLength && m_position.y + m_sideLength < other.getPosition().y + other.getSideLength()) 
-		{
-			return true;
-		}
-	}
-
-	return false;
-}
+float Square::getSideLength() const { return getExtents().x; }
 
-bool Square::collidesWith(const Triangle& other) const 
+std::array<vector2f, 4> Square::getVertices() const 
 {
-    
-    for (const auto& vertex : other.getVertices())
-    {
-        if (containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    return false;
-}
-
-bool Square::collidesWith(const Rectangle& other) const
-{
-    auto vertices = getVertices();
-
-    for (const auto& vertex : vertices)
-    {
-        if (other.containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    
-    return false;
-}
+    vector2f position = getPosition();
 
-float Square::getSideLength() const { return m_sideLength; }
-
-std::array<sf::Vector2f, 4> Square::getVertices() const 
-{
     float halfSideLength = getSideLength() / 2;
     return {
-        sf::Vector2f(getPosition().x - halfSideLength, getPosition().y - halfSideLength), // top-left corner
-        sf::Vector2f(getPosition().x + halfSideLength, getPosition().y - halfSideLength), // top-right corner
-        sf::Vector2f(getPosition().x - halfSideLength, getPosition().y + halfSideLength), // bottom-left corner
-        sf::Vector2f(getPosition().x + halfSideLength, getPosition().y + halfSideLength)  // bottom-right corner
+        vector2f(position.x - halfSideLength, position.y - halfSideLength), // top-left corner
+        vector2f(position.x + halfSideLength, position.y - halfSideLength), // top-right corner
+        vector2f(position.x - halfSideLength, position.y + halfSideLength), // bottom-left corner
+        vector2f(position.x + halfSideLength, position.y + halfSideLength)  // bottom-right corner
     };
 }
 
-bool Square::containsPoint(sf::Vector2f point) const
+polygon Square::getPolygon() const { return polygon::box(getExtents()); }
+
+bool Square::containsPoint(vector2f point) const
 {
-    float halfSize = m_sideLength / 2.0f;
+    vector2f position = getPosition();
 
-    if (point.x >= (m_position.x - halfSize) && point.x <= (m_position.x + halfSize) &&
-        point.y >= (m_position.y - halfSize) && point.y <= (m_position.y + halfSize))
+    float halfSize = getSideLength() / 2.0f;
+
+    if (point.x >= (position.x - halfSize) && point.x <= (position.x + halfSize) &&
+        point.y >= (position.y - halfSize) && point.y <= (position.y + halfSize))
     {
         return true;
     }
@@ -407,171 +166,52 @@ bool Square::containsPoint(sf::Vector2f point) const
 
 std::string Square::toCSVString() const
 {
+    vector2f position = getPosition();
+    vector2f velocity = getVelocity();
+    rgba color = getColor();
+
     std::ostringstream ss;
-    ss << m_position.x << "," << m_position.y << ","
-       << m_velocity.x << "," << m_velocity.y << ","
-       << static_cast<int>(m_color.r) << "," << static_cast<int>(m_color.g) << "," << static_cast<int>(m_color.b) << ","
-       << m_mass << ","
-       << static_cast<int>(m_type) << "," << m_sideLength;
+    ss << position.x << "," << position.y << ","
+       << velocity.x << "," << velocity.y << ","
+       << static_cast<int>(color.r) << "," << static_cast<int>(color.g) << "," << static_cast<int>(color.b) << ","
+       << getMass() << ","
+       << static_cast<int>(getObjectType()) << "," << getSideLength();
     return ss.str();
 }
 
 /* ========== Triangle ========== */
 
-Triangle::Triangle(physicalObjectArgs&& args, float sideLength)
-	: physicalObject(std::move(args)), m_sideLength(sideLength) {}
-
-void Triangle::move(const sf::Vector2f& offset, float deltaTime)
-{
-    m_position += offset * deltaTime;
-    float height = m_sideLength * sqrt(3) / 2.0f;
-    float halfSideLength = m_sideLength / 2.0f;
-    float halfHeight = height / 2.0f;
-
-    // Check if the triangle is out of the map and handle collision
-    if (m_position.x - halfSideLength < 0)
-    {
-        m_position.x = halfSideLength;
-        m_velocity.x = -m_velocity.x;
-    }
-    else if (m_position.y - halfHeight < 0)
-    {
-        m_position.y = halfHeight;
-        m_velocity.y = -m_velocity.y;
-    }
-    else if (m_position.x + halfSideLength > SCREEN_WIDTH)
-    {
-        m_position.x = SCREEN_WIDTH - halfSideLength;
-        m_velocity.x = -m_velocity.x;
-    }
-    else if (m_position.y + halfHeight > SCREEN_LENGTH)
-    {
-        m_position.y = SCREEN_LENGTH - halfHeight;
-        m_velocity.y = -m_velocity.y;
-    }
-}
-
-void Triangle::applyForce(const sf::Vector2f& force) 
-{
-	m_velocity += force / static_cast<float>(m_mass);
-}
+Triangle::Triangle(world& world, physicalObjectArgs&& args, float sideLength)
+	: physicalObject(world, std::move(args), {sideLength, sideLength}) {}
 
-void Triangle::update(float deltaTime)
-{
-	deltaTime *= m_timeAcceleration;
-	move(m_velocity, deltaTime);
-	applyGravity(deltaTime);
-	applyAirResistance(deltaTime);
-}
-
-void Triangle::draw(sf::RenderWindow& window) const 
-{
-	sf::ConvexShape triangle;
-    triangle.setPointCount(3); // Set the number of points to 3 for a triangle
-
-    // Set the points of the triangle
-	float halfBase = m_sideLength / 2.0f;
-    triangle.setPoint(0, sf::Vector2f(0, 0));
-    triangle.setPoint(1, sf::Vector2f(m_sideLength, 0));
-    triangle.setPoint(2, sf::Vector2f(halfBase, halfBase * sqrt(3)));
-
-    triangle.setOrigin(halfBase, halfBase * sqrt(3) / 3);
-
-    triangle.setFillColor(m_color); 
-	if(physicalObject::m_outline)
-	{
-		sf::Color outlineColor = sf::Color{static_cast<sf::Uint8>(255 - m_color.r), static_cast<sf::Uint8>(255 - m_color.g),
-		 static_cast<sf::Uint8>(255 - m_color.b), m_color.a};
-		triangle.setOutlineColor(outlineColor);
-		triangle.setOutlineThickness(2.0f);
-	}
-    triangle.setPosition(m_position); 
-
-    window.draw(triangle); 
-}
+Triangle::Triangle(world& world, uint32_t index)
+	: physicalObject(world, index) {}
 
 objectType Triangle::getType() const 
 {
 	return objectType::Triangle;
 }
 
-bool Triangle::collidesWith(const physicalObject& other) const
-{
-	if (const Circle* circle = dynamic_cast<const Circle*>(&other)) 
-	{
-		return collidesWith(*circle);
-	} 
-	else if (const Square* square = dynamic_cast<const Square*>(&other)) 
-	{
-		return collidesWith(*square);
-	}
-	else if(const Triangle* triangle = dynamic_cast<const Triangle*>(&other))
-	{
-		return collidesWith(*triangle);
-	}
-	else if(const Rectangle* rectangle = dynamic_cast<const Rectangle*>(&other))
-	{
-		return collidesWith(*rectangle);
-	}
-	else return false;
-}
-
-bool Triangle::collidesWith(const Circle& other) const
-{
-	return other.collidesWith(*this);
-}
-
-bool Triangle::collidesWith(const Square& other) const
-{
-	return other.collidesWith(*this);
-}
+float Triangle::getSideLength() const { return getExtents().x; }
 
-bool Triangle::collidesWith(const Triangle& other) const 
+std::array<vector2f, 3> Triangle::getVertices() const
 {
-    auto otherVertices = other.getVertices();
-
-    for (const auto& vertex : otherVertices)
-    {
-        if (containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    return false;
-}
-
-bool Triangle::collidesWith(const Rectangle& other) const
-{
-    auto vertices = getVertices();
-
-    for (const auto& vertex : vertices)
-    {
-        if (other.containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
-
-    return false;
-}
+    vector2f position = getPosition();
 
-float Triangle::getSideLength() const { return m_sideLength; }
-
-std::array<sf::Vector2f, 3> Triangle::getVertices() const
-{
-    std::array<sf::Vector2f, 3> vertices;
-    float halfBase = m_sideLength / 2.0f;
+    std::array<vector2f, 3> vertices;
+    float halfBase = getSideLength() / 2.0f;
     float height = halfBase * sqrt(3);
 
-    vertices[0] = sf::Vector2f(m_position.x - halfBase, m_position.y - height / 3); // The first vertex is at the left corner of the base
-    vertices[1] = sf::Vector2f(m_position.x + halfBase, m_position.y - height / 3); // The second vertex is at the right corner of the base
-    vertices[2] = sf::Vector2f(m_position.x, m_position.y + 2 * height / 3); // The third vertex is at the top of the triangle
+    vertices[0] = vector2f(position.x - halfBase, position.y - height / 3); // The first vertex is at the left corner of the base
+    vertices[1] = vector2f(position.x + halfBase, position.y - height / 3); // The second vertex is at the right corner of the base
+    vertices[2] = vector2f(position.x, position.y + 2 * height / 3); // The third vertex is at the top of the triangle
 
     return vertices;
 }
 
-bool Triangle::containsPoint(sf::Vector2f point) const
+polygon Triangle::getPolygon() const { return polygon::triangle(getSideLength()); }
+
+bool Triangle::containsPoint(vector2f point) const
 {
 	auto vertices = getVertices();
     float area = 0.5f * (-vertices[1].y * vertices[2].x + vertices[0].y * (-vertices[1].x + vertices[2].x) + vertices[0].x * (vertices[1].y - vertices[2].y) + vertices[1].x * vertices[2].y);
@@ -583,166 +223,120 @@ bool Triangle::containsPoint(sf::Vector2f point) const
 
 std::string Triangle::toCSVString() const
 {
+    vector2f position = getPosition();
+    vector2f velocity = getVelocity();
+    rgba color = getColor();
+
     std::ostringstream ss;
-    ss << m_position.x << "," << m_position.y << ","
-       << m_velocity.x << "," << m_velocity.y << ","
-       << static_cast<int>(m_color.r) << "," << static_cast<int>(m_color.g) << "," << static_cast<int>(m_color.b) << ","
-       << m_mass << ","
-       << static_cast<int>(m_type) << "," << m_sideLength;
+    ss << position.x << "," << position.y << ","
+       << velocity.x << "," << velocity.y << ","
+       << static_cast<int>(color.r) << "," << static_cast<int>(color.g) << "," << static_cast<int>(color.b) << ","
+       << getMass() << ","
+       << static_cast<int>(getObjectType()) << "," << getSideLength();
     return ss.str();
 }
 
 /* ========== Rectangle ========== */
 
-Rectangle::Rectangle(physicalObjectArgs&& args, float width, float height)
-	: physicalObject(std::move(args)), m_width(width), m_height(height) {}
+Rectangle::Rectangle(world& world, physicalObjectArgs&& args, float width, float height)
+	: physicalObject(world, std::move(args), {width, height}) {}
 
-void Rectangle::move(const sf::Vector2f& offset, float deltaTime)
-{
-    m_position += offset * deltaTime;
-    float halfWidth = m_width / 2.0f;
-    float halfHeight = m_height / 2.0f;
+Rectangle::Rectangle(world& world, uint32_t index)
+	: physicalObject(world, index) {}
 
-    if (m_position.x - halfWidth < 0)
-    {
-        m_position.x = halfWidth;
-        m_velocity.x = -m_velocity.x;
-    }
-    else if (m_position.y - halfHeight < 0)
-    {
-        m_position.y = halfHeight;
-        m_velocity.y = -m_velocity.y;
-    }
-    else if (m_position.x + halfWidth > SCREEN_WIDTH_F)
-    {
-        m_position.x = SCREEN_WIDTH_F - halfWidth;
-        m_velocity.x = -m_velocity.x;
-    }
-    else if (m_position.y + halfHeight > SCREEN_LENGTH_F)
-    {
-        m_position.y = SCREEN_LENGTH_F - halfHeight;
-        m_velocity.y = -m_velocity.y;
-    }
-}
+objectType Rectangle::getType() const { return objectType::Rectangle; }
 
-void Rectangle::applyForce(const sf::Vector2f& force)
-{
-	m_velocity += force / static_cast<float>(m_mass);
-}
+float Rectangle::getWidth() const { return getExtents().x; }
 
-void Rectangle::update(float deltaTime)
-{
-	deltaTime *= m_timeAcceleration;
-	move(m_velocity, deltaTime);
-	applyGravity(deltaTime);
-	applyAirResistance(deltaTime);
-}
+float Rectangle::getHeight() const { return getExtents().y; }
 
-void Rectangle::draw(sf::RenderWindow& window) const
+bool Rectangle::containsPoint(vector2f point) const
 {
-	sf::RectangleShape rectangle(sf::Vector2f(m_width, m_height));
-	rectangle.setOrigin(m_width / 2.0f, m_height / 2.0f);
-    rectangle.setPosition(m_position);
-    rectangle.setFillColor(m_color);
-	if(physicalObject::m_outline)
-	{
-		sf::Color outlineColor = sf::Color{static_cast<sf::Uint8>(255 - m_color.r), static_cast<sf::Uint8>(255 - m_color.g),
-		 static_cast<sf::Uint8>(255 - m_color.b), m_color.a};
-		rectangle.setOutlineColor(outlineColor);
-		rectangle.setOutlineThickness(2.0f);
-	}
-    window.draw(rectangle);
-}
+    vector2f position = getPosition();
 
-objectType Rectangle::getType() const { return objectType::Rectangle; }
+    float halfWidth = getWidth() / 2.0f;
+    float halfHeight = getHeight() / 2.0f;
 
-bool Rectangle::collidesWith(const physicalObject& other) const
-{
-	if (const Circle* circle = dynamic_cast<const Circle*>(&other)) 
-	{
-		return collidesWith(*circle);
-	} 
-	else if (const Square* square = dynamic_cast<const Square*>(&other)) 
-	{
-		return collidesWith(*square);
-	}
-	else if(const Triangle* triangle = dynamic_cast<const Triangle*>(&other))
-	{
-		return collidesWith(*triangle);
-	}
-	else if(const Rectangle* rectangle = dynamic_cast<const Rectangle*>(&other))
-	{
-		return collidesWith(*rectangle);
-	}
-	else return false;
+    return point.x >= position.x - halfWidth && point.x <= position.x + halfWidth &&
+           point.y >= position.y - halfHeight && point.y <= position.y + halfHeight;
 }
 
-bool Rectangle::collidesWith(const Circle& other) const
+std::array<vector2f, 4> Rectangle::getVertices() const
 {
-	return other.collidesWith(*this);
-}
+    vector2f position = getPosition();
 
-bool Rectangle::collidesWith(const Square& other) const
-{
-	return other.collidesWith(*this);
-}
+    std::array<vector2f, 4> vertices;
 
-bool Rectangle::collidesWith(const Triangle& other) const
-{
-	return 	other.collidesWith(*this);
-}
+    float halfWidth = getWidth() / 2.0f;
+    float halfHeight = getHeight() / 2.0f;
 
-bool Rectangle::collidesWith(const Rectangle& other) const
-{
-    auto otherVertices = other.getVertices();
-    for (const auto& vertex : otherVertices)
-    {
-        if (containsPoint(vertex))
-        {
-            return true;  
-        }
-    }
+    vertices[0] = vector2f(position.x - halfWidth, position.y - halfHeight); // Top-left corner
+    vertices[1] = vector2f(position.x + halfWidth, position.y - halfHeight); // Top-right corner
+    vertices[2] = vector2f(position.x + halfWidth, position.y + halfHeight); // Bottom-right corner
+    vertices[3] = vector2f(position.x - halfWidth, position.y + halfHeight); // Bottom-left corner
 
-    
-    return false;
+    return vertices;
 }
 
-float Rectangle::getWidth() const { return m_width; }
+polygon Rectangle::getPolygon() const { return polygon::box(getExtents()); }
 
-float Rectangle::getHeight() const { return m_height; }
-
-bool Rectangle::containsPoint(sf::Vector2f point) const
+std::string Rectangle::toCSVString() const
 {
-    float halfWidth = m_width / 2.0f;
-    float halfHeight = m_height / 2.0f;
+    vector2f position = getPosition();
+    vector2f velocity = getVelocity();
+    rgba color = getColor();
 
-    return point.x >= m_position.x - halfWidth && point.x <= m_position.x + halfWidth &&
-           point.y >= m_position.y - halfHeight && point.y <= m_position.y + halfHeight;
+    std::ostringstream ss;
+    ss << position.x << "," << position.y << ","
+       << velocity.x << "," << velocity.y << ","
+       << static_cast<int>(color.r) << "," << static_cast<int>(color.g) << "," << static_cast<int>(color.b) << ","
+       << getMass() << ","
+       << static_cast<int>(getObjectType()) << "," << getWidth() << "," << getHeight();
+    return ss.str();
 }
 
-std::array<sf::Vector2f, 4> Rectangle::getVertices() const
-{
-    std::array<sf::Vector2f, 4> vertices;
+/* ========== Convex ========== */
+
+Convex::Convex(world& world, physicalObjectArgs&& args, const polygon& shape)
+	: physicalObject(world, std::move(args), shape) {}
 
-    float halfWidth = m_width / 2.0f;
-    float halfHeight = m_height / 2.0f;
+Convex::Convex(world& world, uint32_t index)
+	: physicalObject(world, index) {}
 
-    vertices[0] = sf::Vector2f(m_position.x - halfWidth, m_position.y - halfHeight); // Top-left corner
-    vertices[1] = sf::Vector2f(m_position.x + halfWidth, m_position.y - halfHeight); // Top-right corner
-    vertices[2] = sf::Vector2f(m_position.x + halfWidth, m_position.y + halfHeight); // Bottom-right corner
-    vertices[3] = sf::Vector2f(m_position.x - halfWidth, m_position.y + halfHeight); // Bottom-left corner
+objectType Convex::getType() const { return objectType::Convex; }
 
+const polygon& Convex::getPolygon() const { return m_world->getPolygon(m_index); }
+
+std::vector<vector2f> Convex::getVertices() const
+{
+    const polygon& shape = getPolygon();
+    vector2f position = getPosition();
+    std::vector<vector2f> vertices(shape.count);
+    for(uint32_t i = 0; i < shape.count; ++i)
+    {
+        vertices[i] = position + shape.vertices[i];
+    }
     return vertices;
 }
 
-std::string Rectangle::toCSVString() const
+std::string Convex::toCSVString() const
 {
+    vector2f position = getPosition();
+    vector2f velocity = getVelocity();
+    rgba color = getColor();
+    const polygon& shape = getPolygon();
+
+    // The vertex count, then the local-space vertices.
     std::ostringstream ss;
-    ss << m_position.x << "," << m_position.y << ","
-       << m_velocity.x << "," << m_velocity.y << ","
-       << static_cast<int>(m_color.r) << "," << static_cast<int>(m_color.g) << "," << static_cast<int>(m_color.b) << ","
-       << m_mass << ","
-       << static_cast<int>(m_type) << "," << m_width << "," << m_height;
+    ss << position.x << "," << position.y << ","
+       << velocity.x << "," << velocity.y << ","
+       << static_cast<int>(color.r) << "," << static_cast<int>(color.g) << "," << static_cast<int>(color.b) << ","
+       << getMass() << ","
+       << static_cast<int>(getObjectType()) << "," << shape.count;
+    for(uint32_t i = 0; i < shape.count; ++i)
+    {
+        ss << "," << shape.vertices[i].x << "," << shape.vertices[i].y;
+    }
     return ss.str();
 }
 
@@ -1,13 +1,15 @@
 #include "uimanager.h"
 #include "types.h"
 #include "physim.h"
+#include <algorithm>
 
 namespace kq {
 
 UIManager::UIManager(physim* parent)
-    : m_parent(parent), m_toggle(false), m_type(objectType::Circle), m_radius(100.f), m_rotation(0.f), m_size({100.f, 100.f}),
-    m_velocity({50.f, 50.f}), m_play(false), m_color(), m_selected(0), m_showSelected(false), m_mass(1), m_exportMenu(false),
-    m_importMenu(false)
+    : m_parent(parent), m_toggle(false), m_type(objectType::Circle), m_radius(100.f), m_rotation(0.f), m_size({100.f, 100.f}), m_sides(6),
+    m_velocity({50.f, 50.f}), m_play(false), m_color(), m_selected(), m_mass(1), m_exportMenu(false),
+    m_importMenu(false), m_listFilter(), m_listRowsFilter(), m_listRows(), m_listRowsRevision(UINT64_MAX), m_heaviest(0.f),
+    m_import(), m_importShown(false), m_writer()
 {
 
 }
@@ -29,6 +31,7 @@ void UIManager::show()
     objectPanel();
     importPanel();
     exportPanel();
+    profilerPanel();
 }
 
 void UIManager::play()
@@ -52,16 +55,35 @@ float UIManager::getRadius() { return m_radius; }
 
 float UIManager::getRotation() { return m_rotation * (pi / 180.0f); }
 
-sf::Vector2f UIManager::getSize() { return m_size; }
+vector2f UIManager::getSize() { return m_size; }
 
-sf::Vector2f UIManager::getVelocity() {return m_velocity; }
+int UIManager::getSides() { return m_sides; }
 
-bool UIManager::isSelected() { return m_showSelected; }
+vector2f UIManager::getVelocity() {return m_velocity; }
 
-uint32_t UIManager::getSelected() { return m_selected; }
+bool UIManager::isSelected() { return getSelected() != world::invalidIndex; }
+
+uint32_t UIManager::getSelected() { return m_parent->getState().bodies.getIndex(m_selected); }
+
+bodyHandle UIManager::getSelectedHandle() const { return m_selected; }
+
+void UIManager::select(uint32_t index)
+{
+    m_selected = m_parent->getState().bodies.getHandle(index);
+}
+
+void UIManager::select(bodyHandle handle)
+{
+    m_selected = handle;
+}
 
 float UIManager::getMass() { return m_mass;}
 
+void UIManager::post(simulationThread::command command)
+{
+    m_parent->getSimulationThread().post(std::move(command));
+}
+
 
 void UIManager::editPanel()
 {
@@ -83,7 +105,7 @@ void UIManager::editPanel()
     ImGui::SameLine();
     if(ImGui::Button("Impulse"))
     {
-        m_parent->Impulse();
+        post([](simulation& simulation) { simulation.Impulse(); });
     }
     ImGui::SameLine();
     if(ImGui::Button("Export"))
@@ -95,6 +117,12 @@ void UIManager::editPanel()
     {
         m_importMenu = !m_importMenu;
     }
+    ImGui::SameLine();
+    if(ImGui::Button("Profiler"))
+    {
+        profiler& profile = m_parent->getProfiler();
+        profile.setEnabled(!profile.isEnabled());
+    }
 
     ImGui::ListBox("Type of object", reinterpret_cast<int*>(&m_type), m_types, sizeof(m_types) / sizeof(m_types[0]), 4);
     ImGui::SliderFloat("Mass of object", &m_mass, 1.f, 100.f, "%.2f");
@@ -119,7 +147,10 @@ void UIManager::editPanel()
     }
     else if(m_type == objectType::Convex)
     {
-
+        // A regular polygon; files can hold any convex outline.
+        ImGui::SliderInt("Sides", &m_sides, 3, static_cast<int>(polygon::maxVertices));
+        ImGui::SliderFloat("Radius of object ", &m_radius, 50.f, 150.f, "%.2f");
+        ImGui::SliderFloat("Rotation", &m_rotation, 0.f, 360.f, "%.0f");
     }
 
     static float colorInternal[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -139,9 +170,113 @@ void UIManager::editPanel()
             static_cast<int>(m_color[3] * 255));
     ImGui::Text("Hex: %s", hexColor);
 
-    ImGui::SliderFloat("Gravity force", &physicalObject::m_gravity, 0.f, 100.f, "%.2f");
-    ImGui::SliderFloat("Air Resistance", &physicalObject::m_airResistance, 0.f, 0.5f, "%.2f");
-    ImGui::SliderFloat("Time acceleration", &physicalObject::m_timeAcceleration, 0.1f, 10.f, "%.2f");
+    // Widgets show the published settings and post what they change; the next state carries it.
+    const simulationState& state = m_parent->getState();
+    simulationSettings settings = state.settings;
+    if(ImGui::SliderFloat("Gravity force", &settings.gravity, 0.f, 100.f, "%.2f"))
+    {
+        post([gravity = settings.gravity](simulation&) { physicalObject::m_gravity = gravity; });
+    }
+    if(ImGui::SliderFloat("Air Resistance", &settings.airResistance, 0.f, 0.5f, "%.2f"))
+    {
+        post([airResistance = settings.airResistance](simulation&) { physicalObject::m_airResistance = airResistance; });
+    }
+    vector2f worldSize = state.bodies.getSize();
+    if(ImGui::DragFloat2("World size", &worldSize.x, 10.f, 100.f, 100000.f, "%.0f"))
+    {
+        post([worldSize](simulation& simulation) { simulation.getWorld().setSize(worldSize); });
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Fit"))
+    {
+        m_parent->resetCamera();
+    }
+    if(ImGui::SliderFloat("Time acceleration", &settings.timeAcceleration, 0.1f, 10.f, "%.2f"))
+    {
+        post([acceleration = settings.timeAcceleration](simulation&) { physicalObject::m_timeAcceleration = acceleration; });
+    }
+    float stepRate = 1.f / settings.stepSize;
+    if(ImGui::SliderFloat("Steps per second", &stepRate, 30.f, 480.f, "%.0f"))
+    {
+        post([stepRate](simulation& simulation) { simulation.getStepSize() = 1.f / stepRate; });
+    }
+    if(ImGui::SliderInt("Max substeps", &settings.maxSubsteps, 1, 32))
+    {
+        post([maxSubsteps = settings.maxSubsteps](simulation& simulation) { simulation.getMaxSubsteps() = maxSubsteps; });
+    }
+    ImGui::Text("Steps last advance: %d", static_cast<int>(state.stepCount));
+
+    int threads = static_cast<int>(settings.threads);
+    if(ImGui::SliderInt("Worker threads", &threads, 1, static_cast<int>(m_parent->getMaxSimulationThreads())))
+    {
+        post([threads](simulation& simulation) { simulation.getThreadPool().setThreadCount(static_cast<uint32_t>(threads)); });
+    }
+
+    if(ImGui::Combo("Broadphase", reinterpret_cast<int*>(&settings.broadphase), m_broadphases, IM_ARRAYSIZE(m_broadphases)))
+    {
+        post([broadphase = settings.broadphase](simulation& simulation) { simulation.getCollider().getBroadphase() = broadphase; });
+    }
+    if(settings.broadphase == broadphaseType::Grid)
+    {
+        if(ImGui::SliderFloat("Grid cell size", &settings.cellSize, 25.f, 600.f, "%.0f"))
+        {
+            post([cellSize = settings.cellSize](simulation& simulation) { simulation.getCollider().setCellSize(cellSize); });
+        }
+        ImGui::Text("Candidate pairs: %d", static_cast<int>(state.pairCount));
+    }
+    else if(settings.broadphase == broadphaseType::Tree)
+    {
+        if(ImGui::SliderFloat("Tree margin", &settings.treeMargin, 0.f, 50.f, "%.1f"))
+        {
+            post([margin = settings.treeMargin](simulation& simulation) { simulation.getCollider().setTreeMargin(margin); });
+        }
+        ImGui::Text("Tree height: %d", state.treeHeight);
+        ImGui::Text("Candidate pairs: %d", static_cast<int>(state.pairCount));
+    }
+    if(ImGui::Checkbox("Batched circle tests", &settings.batchedCircles))
+    {
+        post([batched = settings.batchedCircles](simulation& simulation) { simulation.getCollider().getBatchedCircles() = batched; });
+    }
+    ImGui::SameLine();
+    ImGui::Text("(%s)", circleKernel::getInstructionSetName(circleKernel::getInstructionSet()));
+    ImGui::Text("Contacts: %d in %d parallel batches", static_cast<int>(state.contacts.size()),
+                static_cast<int>(state.colorCount));
+
+    if(ImGui::SliderInt("Solver iterations", &settings.solverIterations, 1, 32))
+    {
+        post([iterations = settings.solverIterations](simulation& simulation) { simulation.getSolver().getIterations() = iterations; });
+    }
+    if(ImGui::Checkbox("Warm starting", &settings.warmStarting))
+    {
+        post([warm = settings.warmStarting](simulation& simulation) { simulation.getSolver().getWarmStarting() = warm; });
+    }
+    ImGui::SameLine();
+    ImGui::Text("(%d manifolds)", static_cast<int>(state.manifoldCount));
+
+    if(ImGui::Checkbox("Continuous collision", &settings.continuous))
+    {
+        post([enabled = settings.continuous](simulation& simulation) { simulation.getContinuousCollider().getEnabled() = enabled; });
+    }
+    ImGui::SameLine();
+    ImGui::Text("(%d fast, %d stopped)", static_cast<int>(state.fastCount), static_cast<int>(state.impactCount));
+
+    if(ImGui::Checkbox("Sleeping", &settings.sleeping))
+    {
+        post([enabled = settings.sleeping](simulation& simulation) { simulation.getIslands().getEnabled() = enabled; });
+    }
+    ImGui::SameLine();
+    ImGui::Text("(%d asleep)", static_cast<int>(state.sleepingCount));
+    if(settings.sleeping)
+    {
+        if(ImGui::SliderFloat("Sleep speed", &settings.sleepSpeed, 0.f, 50.f, "%.1f"))
+        {
+            post([speed = settings.sleepSpeed](simulation& simulation) { simulation.getIslands().getSleepSpeed() = speed; });
+        }
+        if(ImGui::SliderFloat("Sleep time", &settings.sleepTime, 0.1f, 5.f, "%.2f s"))
+        {
+            post([time = settings.sleepTime](simulation& simulation) { simulation.getIslands().getSleepTime() = time; });
+        }
+    }
 
     ImGui::End();
     
@@ -149,77 +284,197 @@ void UIManager::editPanel()
 
 void UIManager::listPanel()
 {
-    const std::vector<physicalObject*>& entities = m_parent->getEntities();
+    const world& world = m_parent->getState().bodies;
     ImGui::Begin("List Panel");
 
     if(ImGui::Button("Clear list"))
     {
-        m_parent->clearEntities();
-        m_showSelected = false;
+        post([](simulation& simulation) { simulation.clearEntities(); });
     }
-    static ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable;
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(120.f);
+    ImGui::Combo("Type##filter", &m_listFilter.type, m_listTypes, IM_ARRAYSIZE(m_listTypes));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(160.f);
+    // Dragging the upper end to the heaviest body lifts the limit again, so bodies added later
+    // are not filtered out.
+    float massLimit = std::max(m_heaviest, 100.f);
+    bool unlimited = m_listFilter.maxMass == FLT_MAX;
+    if(ImGui::DragFloatRange2("Mass##filter", &m_listFilter.minMass, &m_listFilter.maxMass, 0.5f, 0.f, massLimit, "%.1f",
+                              unlimited ? "no limit" : "%.1f") && m_listFilter.maxMass >= massLimit)
+        m_listFilter.maxMass = FLT_MAX;
+
+    static ImGuiTableFlags flags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersV | ImGuiTableFlags_Resizable | ImGuiTableFlags_Reorderable | ImGuiTableFlags_Hideable | ImGuiTableFlags_Sortable;
     const float TEXT_BASE_HEIGHT = ImGui::GetTextLineHeightWithSpacing();
     ImVec2 outer_size = ImVec2(0.0f, TEXT_BASE_HEIGHT * 8);
     if (ImGui::BeginTable("list_objects", 5, flags, outer_size))
     {
         ImGui::TableSetupScrollFreeze(0, 1); // Make top row always visible
-        ImGui::TableSetupColumn("Index", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Index", ImGuiTableColumnFlags_DefaultSort);
         ImGui::TableSetupColumn("Type", ImGuiTableColumnFlags_None);
-        ImGui::TableSetupColumn("Color", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("Color", ImGuiTableColumnFlags_NoSort);
         ImGui::TableSetupColumn("Mass", ImGuiTableColumnFlags_None);
-        ImGui::TableSetupColumn("View", ImGuiTableColumnFlags_None);
+        ImGui::TableSetupColumn("View", ImGuiTableColumnFlags_NoSort);
         ImGui::TableHeadersRow();
 
-        for (uint32_t i = 0; i < entities.size(); ++i)
+        ImGuiTableSortSpecs* sortSpecs = ImGui::TableGetSortSpecs();
+        if(sortSpecs != nullptr && sortSpecs->SpecsDirty)
         {
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0);
-            ImGui::Text(itos(i).data());
-            ImGui::TableSetColumnIndex(1);
-            ImGui::Text(getShapeName(entities[i]->getType()).data());
-            ImGui::TableSetColumnIndex(2);
-            getColorBox(entities[i]->getColor());
-            ImGui::TableSetColumnIndex(3);
-            ImGui::Text("%.2f", entities[i]->getMass());
-            ImGui::TableSetColumnIndex(4);
-            std::string buttonLabel = "View##" + std::to_string(i);
-            if(ImGui::Button(buttonLabel.data()))
+            m_listFilter.sortColumn = sortSpecs->SpecsCount > 0 ? sortSpecs->Specs[0].ColumnIndex : 0;
+            m_listFilter.ascending = sortSpecs->SpecsCount == 0 || sortSpecs->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+            sortSpecs->SpecsDirty = false;
+        }
+        updateListRows();
+
+        // Only the rows in view are submitted, and none of them allocates.
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(m_listRows.size()));
+        while(clipper.Step())
+        {
+            for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
             {
-                m_selected = i;
-                m_showSelected = true;
+                uint32_t i = m_listRows[row];
+                ImGui::PushID(static_cast<int>(i));
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%u", i);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::TextUnformatted(getShapeName(world.getTypes()[i]));
+                ImGui::TableSetColumnIndex(2);
+                getColorBox(world.getInfo()[i].color);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%.2f", world.getMasses()[i]);
+                ImGui::TableSetColumnIndex(4);
+                if(ImGui::Button("View"))
+                {
+                    select(i);
+                }
+                ImGui::PopID();
             }
         }
-        
+
         ImGui::EndTable();
     }
+    ImGui::Text("%d of %d bodies", static_cast<int>(m_listRows.size()), static_cast<int>(world.size()));
 
     ImGui::End();
 }
 
+void UIManager::updateListRows()
+{
+    const world& world = m_parent->getState().bodies;
+    if(m_listRowsRevision == world.getRevision() && m_listRowsFilter == m_listFilter)
+        return;
+    m_listRowsRevision = world.getRevision();
+    m_listRowsFilter = m_listFilter;
+
+    const std::vector<objectType>& types = world.getTypes();
+    const std::vector<float>& masses = world.getMasses();
+    m_listRows.clear();
+    m_heaviest = 0.f;
+    for(uint32_t i = 0; i < world.size(); ++i)
+    {
+        m_heaviest = std::max(m_heaviest, masses[i]);
+        bool typeMatches = m_listFilter.type == 0 || static_cast<int>(types[i]) == m_listFilter.type - 1;
+        if(typeMatches && masses[i] >= m_listFilter.minMass && masses[i] <= m_listFilter.maxMass)
+            m_listRows.push_back(i);
+    }
+
+    // Ties keep index order, so equal keys do not shuffle between rebuilds.
+    auto key = [&](uint32_t i)
+    {
+        switch(m_listFilter.sortColumn)
+        {
+            case 1: return static_cast<float>(types[i]);
+            case 3: return masses[i];
+            default: return 0.f;
+        }
+    };
+    std::sort(m_listRows.begin(), m_listRows.end(), [&](uint32_t a, uint32_t b)
+    {
+        float keyA = key(a);
+        float keyB = key(b);
+        if(keyA != keyB)
+            return m_listFilter.ascending ? keyA < keyB : keyA > keyB;
+        return m_listFilter.ascending || m_listFilter.sortColumn != 0 ? a < b : a > b;
+    });
+}
+
 void UIManager::objectPanel()
 {
-    if(!m_showSelected)
+    uint32_t selected = getSelected();
+    if(selected == world::invalidIndex)
         return;
 
+    const simulationState& state = m_parent->getState();
+    const world& world = state.bodies;
     ImGui::Begin("Object Panel");
-    ImGui::Text("Type: %s", getShapeName(m_parent->getEntities()[m_selected]->getType()).data());
-    ImGui::Text("Color: "); ImGui::SameLine(); getColorBox(m_parent->getEntities()[m_selected]->getColor());
-    ImGui::Text("Mass: %.2f", m_parent->getEntities()[m_selected]->getMass());
-
-    sf::Vector2f position = m_parent->getEntities()[m_selected]->getPosition();
-    sf::Vector2f velocity = m_parent->getEntities()[m_selected]->getVelocity();
+    ImGui::Text("Type: %s", getShapeName(world.getTypes()[selected]));
+    ImGui::Text("Color: "); ImGui::SameLine(); getColorBox(world.getInfo()[selected].color);
+    ImGui::Text("Mass: %.2f", world.getMasses()[selected]);
+
+    // Edits go to the body by handle, it may have moved to another index by the time they run.
+    // Editing a body wakes it, otherwise a sleeping body would ignore the new values.
+    bodyHandle handle = m_selected;
+    vector2f position = world.getPositions()[selected];
+    vector2f velocity = world.getVelocities()[selected];
+    if(ImGui::DragFloat2("Position", &position.x, 1.f))
+    {
+        post([handle, position](simulation& simulation)
+        {
+            uint32_t index = simulation.getWorld().getIndex(handle);
+            if(index == world::invalidIndex)
+                return;
+            simulation.getWorld().getPositions()[index] = position;
+            simulation.getWorld().wake(index);
+        });
+    }
+    if(ImGui::DragFloat2("Velocity", &velocity.x, 1.f))
+    {
+        post([handle, velocity](simulation& simulation)
+        {
+            uint32_t index = simulation.getWorld().getIndex(handle);
+            if(index == world::invalidIndex)
+                return;
+            simulation.getWorld().getVelocities()[index] = velocity;
+            simulation.getWorld().wake(index);
+        });
+    }
+    ImGui::Text("State: %s", world.isAsleep(selected) ? "asleep" : "awake");
+    ImGui::SameLine();
+    if(ImGui::Button("Wake"))
+    {
+        post([handle](simulation& simulation)
+        {
+            uint32_t index = simulation.getWorld().getIndex(handle);
+            if(index != world::invalidIndex)
+                simulation.getWorld().wake(index);
+        });
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Remove"))
+    {
+        post([handle](simulation& simulation) { simulation.removeObject(handle); });
+        ImGui::End();
+        return;
+    }
 
-    ImGui::Text("Position: (%f, %f)", position.x, position.y);
-    ImGui::Text("Velocity: (%f, %f)", velocity.x, velocity.y);
+    ImGui::Text("Collisions: %d", static_cast<int>(world.getInfo()[selected].collisions));
 
-    // Placeholder for collisions
-    ImGui::Text("Collisions: %d", m_parent->getEntities()[m_selected]->getCollisions());
+    for(const contact& contact : state.contacts)
+    {
+        if(contact.first != selected && contact.second != selected)
+            continue;
+        bool first = contact.first == selected;
+        ImGui::Text("Touching %d (%s), depth %.2f", first ? contact.second : contact.first,
+                    getShapeName(first ? contact.secondType : contact.firstType), contact.penetration);
+    }
 
     ImGui::End();
 }
 
 
-std::string UIManager::getShapeName(objectType type)
+const char* UIManager::getShapeName(objectType type)
 {
     switch(type)
     {
@@ -238,7 +493,7 @@ std::string UIManager::getShapeName(objectType type)
     }
 }
 
-void UIManager::getColorBox(sf::Color color)
+void UIManager::getColorBox(rgba color)
 {
     uint8_t colors[4] = { color.r, color.g, color.b, color.a };
     ImVec4 imguiColor = ImVec4(colors[0] / 255.f, colors[1] / 255.f, colors[2] / 255.f, colors[3] / 255.f);
@@ -262,28 +517,47 @@ void UIManager::importPanel()
     ImGui::Begin("Import Menu");
     static char filename[128] = "";
     ImGui::InputText("Filename", filename, IM_ARRAYSIZE(filename));
-    
-    static bool error = false;
 
-    if(ImGui::Button("Import"))
+    // The scene is loaded on the simulation thread, the result comes back through m_import.
+    bool loading = m_import != nullptr && !m_import->done;
+    if(loading)
     {
-        error = false;
-        m_parent->clearEntities();
-        auto vec = m_parent->getEntities();
-        bool result = m_parent->getFileManager().loadcsv(filename, vec);
-        if(result == true)
+        ImGui::Text("Loading %s", filename);
+    }
+    else if(ImGui::Button("Import"))
+    {
+        m_import = std::make_shared<importStatus>();
+        m_importShown = false;
+        post([status = m_import, name = std::string(filename)](simulation& simulation)
         {
+            simulation.clearEntities();
+            // CSV or snapshot, told apart by the file's magic number.
+            status->loaded = simulation.getFileManager().load(name);
+            status->errors = simulation.getFileManager().getErrors();
+            status->done = true;
+        });
+    }
+
+    if(m_import != nullptr && m_import->done)
+    {
+        // Stay open to show the skipped rows.
+        if(!m_importShown && m_import->loaded && m_import->errors.empty())
             m_importMenu = false;
+        m_importShown = true;
+        if(!m_import->loaded)
+        {
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error: File not found or not a scene");
         }
-        else
+        const auto& rowErrors = m_import->errors;
+        if(!rowErrors.empty())
         {
-            error = true;
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "Skipped %d malformed rows:", static_cast<int>(rowErrors.size()));
+            for(size_t i = 0; i < rowErrors.size() && i < 10; ++i)
+            {
+                ImGui::Text("Line %llu: %s", static_cast<unsigned long long>(rowErrors[i].line), rowErrors[i].message.data());
+            }
         }
     }
-    if(error)
-    {
-        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error: File not found");
-    }
     ImGui::End();
 }
 
@@ -297,28 +571,79 @@ void UIManager::exportPanel()
     ImGui::InputText("Filename", filename, IM_ARRAYSIZE(filename));
     
     static bool error = false;
+    static bool writing = false;
 
-    if(ImGui::Button("Export"))
+    ImGui::Text("Names ending in %s are saved as binary snapshots, others as CSV.", fileManager::snapshotExtension);
+    // The file is written from the published state on a background thread, the simulation
+    // keeps running meanwhile.
+    if(m_writer.isBusy())
     {
-        error = false;
-        const auto vec = m_parent->getEntities();
-        bool result = m_parent->getFileManager().savecsv(filename, vec);
-        if(result == true)
-        {
+        ImGui::ProgressBar(m_writer.getProgress(), ImVec2(-1.f, 0.f));
+        ImGui::Text("Writing %s", m_writer.getFilename().data());
+    }
+    else if(writing)
+    {
+        writing = false;
+        error = m_writer.hasFailed();
+        if(!error)
             m_exportMenu = false;
-        }
-        else
-        {
-            error = true;
-        }
+    }
+    else if(ImGui::Button("Export"))
+    {
+        error = false;
+        writing = m_writer.start(m_parent->getState().bodies, filename, fileManager::formatFromExtension(filename));
     }
 
     if(error)
     {
-        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error: File not found");
+        ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Error: could not write %s", m_writer.getFilename().data());
+    }
+
+    ImGui::End();
+}
+
+void UIManager::profilerPanel()
+{
+    profiler& profile = m_parent->getProfiler();
+    if(!profile.isEnabled())
+        return;
+
+    bool open = true;
+    ImGui::Begin("Profiler", &open);
+
+    char overlay[64];
+    sprintf(overlay, "%.2f ms, p99 %.2f ms", profile.getAverage(profilePhase::Frame), profile.getPercentile(profilePhase::Frame, 0.99f));
+    ImGui::PlotLines("Frame time", profile.getHistory(profilePhase::Frame), static_cast<int>(profile.getFrameCount()),
+                     static_cast<int>(profile.getHistoryOffset()), overlay, 0.f, 50.f, ImVec2(0, 80));
+
+    if(ImGui::BeginTable("Phases", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersOuter))
+    {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Average (ms)");
+        ImGui::TableSetupColumn("p99 (ms)");
+        ImGui::TableHeadersRow();
+        for(uint32_t i = 0; i < profiler::phaseCount; ++i)
+        {
+            profilePhase phase = static_cast<profilePhase>(i);
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(profiler::getPhaseName(phase));
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", profile.getAverage(phase));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.3f", profile.getPercentile(phase, 0.99f));
+        }
+        ImGui::EndTable();
     }
 
+    ImGui::Text("Bodies: %d", static_cast<int>(profile.getBodies()));
+    ImGui::Text("Candidate pairs: %d", static_cast<int>(profile.getPairs()));
+    ImGui::Text("Contacts: %d", static_cast<int>(profile.getContacts()));
+    ImGui::Text("Steps last advance: %d", static_cast<int>(m_parent->getState().stepCount));
+
     ImGui::End();
+    if(!open)
+        profile.setEnabled(false);
 }
 
 } // namespace kq
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "world.h"
+#include "types.h"
+#include <algorithm>
+#include <cmath>
+
+namespace kq
+{
+
+world::world()
+    : m_positions(), m_previousPositions(), m_velocities(), m_masses(), m_invMasses(), m_extents(), m_localBounds(), m_types(), m_asleep(), m_sleepTimers(), m_shapes(),
+    m_info(), m_polygons(), m_freePolygons(), m_slots(), m_freeSlots(), m_bodySlots(),
+    m_size(SCREEN_WIDTH_F, SCREEN_LENGTH_F), m_revision(0)
+{
+
+}
+
+uint32_t world::add(const physicalObjectArgs& args, vector2f extents)
+{
+    uint32_t index = size();
+    m_positions.push_back(args.position);
+    m_previousPositions.push_back(args.position);
+    m_velocities.push_back(args.velocity);
+    m_masses.push_back(args.mass);
+    m_invMasses.push_back(1 / args.mass);
+    m_extents.push_back(extents);
+    m_localBounds.push_back(localBounds(args.type, extents));
+    m_types.push_back(args.type);
+    m_asleep.push_back(0);
+    m_sleepTimers.push_back(0.f);
+    m_shapes.push_back(invalidIndex);
+    m_info.push_back({args.color, 0});
+    addSlot(index);
+    ++m_revision;
+    return index;
+}
+
+uint32_t world::add(const physicalObjectArgs& args, const polygon& shape)
+{
+    AABB bounds = shape.getBounds();
+    uint32_t index = add(args, bounds.max - bounds.min);
+    m_localBounds[index] = bounds;
+    m_shapes[index] = addPolygon(shape);
+    return index;
+}
+
+uint32_t world::append(uint32_t count, const vector2f* positions, const vector2f* velocities, const float* masses,
+                       const objectType* types, const vector2f* extents, const rgba* colors,
+                       const polygon* polygons)
+{
+    uint32_t first = size();
+    m_positions.insert(m_positions.end(), positions, positions + count);
+    m_previousPositions.insert(m_previousPositions.end(), positions, positions + count);
+    m_velocities.insert(m_velocities.end(), velocities, velocities + count);
+    m_masses.insert(m_masses.end(), masses, masses + count);
+    m_extents.insert(m_extents.end(), extents, extents + count);
+    m_types.insert(m_types.end(), types, types + count);
+    m_asleep.resize(first + count, 0);
+    m_sleepTimers.resize(first + count, 0.f);
+
+    m_invMasses.reserve(first + count);
+    m_localBounds.reserve(first + count);
+    m_shapes.reserve(first + count);
+    m_info.reserve(first + count);
+    for(uint32_t i = 0; i < count; ++i)
+    {
+        m_invMasses.push_back(1 / masses[i]);
+        if(types[i] == objectType::Convex)
+        {
+            m_localBounds.push_back(polygons->getBounds());
+            m_shapes.push_back(addPolygon(*polygons++));
+        }
+        else
+        {
+            m_localBounds.push_back(localBounds(types[i], extents[i]));
+            m_shapes.push_back(invalidIndex);
+        }
+        m_info.push_back({colors[i], 0});
+        addSlot(first + i);
+    }
+    ++m_revision;
+    return first;
+}
+
+void world::remove(uint32_t index)
+{
+    slot& removed = m_slots[m_bodySlots[index]];
+    removed.index = invalidIndex;
+    ++removed.generation;
+    m_freeSlots.push_back(m_bodySlots[index]);
+    if(m_shapes[index] != invalidIndex)
+        m_freePolygons.push_back(m_shapes[index]);
+
+    uint32_t last = size() - 1;
+    auto moveLast = [&](auto& values)
+    {
+        values[index] = values[last];
+        values.pop_back();
+    };
+    moveLast(m_positions);
+    moveLast(m_previousPositions);
+    moveLast(m_velocities);
+    moveLast(m_masses);
+    moveLast(m_invMasses);
+    moveLast(m_extents);
+    moveLast(m_localBounds);
+    moveLast(m_types);
+    moveLast(m_asleep);
+    moveLast(m_sleepTimers);
+    moveLast(m_shapes);
+    moveLast(m_info);
+    moveLast(m_bodySlots);
+    if(index != last)
+        m_slots[m_bodySlots[index]].index = index;
+    ++m_revision;
+}
+
+void world::clear()
+{
+    // Retires every live slot, which is what keeps old handles from resolving to new bodies.
+    for(uint32_t slotIndex : m_bodySlots)
+    {
+        m_slots[slotIndex].index = invalidIndex;
+        ++m_slots[slotIndex].generation;
+        m_freeSlots.push_back(slotIndex);
+    }
+    m_bodySlots.clear();
+    ++m_revision;
+
+    m_positions.clear();
+    m_previousPositions.clear();
+    m_velocities.clear();
+    m_masses.clear();
+    m_invMasses.clear();
+    m_extents.clear();
+    m_localBounds.clear();
+    m_types.clear();
+    m_asleep.clear();
+    m_sleepTimers.clear();
+    m_shapes.clear();
+    m_info.clear();
+    m_polygons.clear();
+    m_freePolygons.clear();
+}
+
+uint32_t world::size() const { return static_cast<uint32_t>(m_positions.size()); }
+
+uint64_t world::getRevision() const { return m_revision; }
+
+bodyHandle world::getHandle(uint32_t index) const
+{
+    uint32_t slotIndex = m_bodySlots[index];
+    return {slotIndex, m_slots[slotIndex].generation};
+}
+
+uint32_t world::getIndex(bodyHandle handle) const
+{
+    if(handle.slot >= m_slots.size() || m_slots[handle.slot].generation != handle.generation)
+        return invalidIndex;
+    return m_slots[handle.slot].index;
+}
+
+void world::addSlot(uint32_t index)
+{
+    if(m_freeSlots.empty())
+    {
+        m_bodySlots.push_back(static_cast<uint32_t>(m_slots.size()));
+        m_slots.push_back({index, 0});
+        return;
+    }
+    uint32_t slotIndex = m_freeSlots.back();
+    m_freeSlots.pop_back();
+    m_slots[slotIndex].index = index;
+    m_bodySlots.push_back(slotIndex);
+}
+
+uint32_t world::addPolygon(const polygon& shape)
+{
+    if(m_freePolygons.empty())
+    {
+        m_polygons.push_back(shape);
+        return static_cast<uint32_t>(m_polygons.size() - 1);
+    }
+    uint32_t polygonIndex = m_freePolygons.back();
+    m_freePolygons.pop_back();
+    m_polygons[polygonIndex] = shape;
+    return polygonIndex;
+}
+
+void world::integrate(float deltaTime)
+{
+    integrate(deltaTime, 0, size());
+}
+
+void world::integrate(float deltaTime, uint32_t begin, uint32_t end)
+{
+    const float gravity = physicalObject::m_gravity;
+    const float airResistance = physicalObject::m_airResistance;
+    const vector2f size = m_size;
+
+    for(uint32_t i = begin; i < end; ++i)
+    {
+        if(m_asleep[i])
+            continue;
+
+        vector2f& position = m_positions[i];
+        vector2f& velocity = m_velocities[i];
+        m_previousPositions[i] = position;
+
+        velocity.y += gravity * m_masses[i] * deltaTime;
+        velocity *= 1.0f - airResistance * deltaTime * m_invMasses[i];
+        position += velocity * deltaTime;
+
+        // Bounce off the world edges.
+        const AABB& local = m_localBounds[i];
+        if(position.x + local.min.x < 0)
+        {
+            position.x = -local.min.x;
+            velocity.x *= -1;
+        }
+        else if(position.x + local.max.x > size.x)
+        {
+            position.x = size.x - local.max.x;
+            velocity.x *= -1;
+        }
+
+        if(position.y + local.min.y < 0)
+        {
+            position.y = -local.min.y;
+            velocity.y *= -1;
+        }
+        else if(position.y + local.max.y > size.y)
+        {
+            position.y = size.y - local.max.y;
+            velocity.y *= -1;
+        }
+    }
+}
+
+vector2f world::getSize() const { return m_size; }
+
+void world::setSize(vector2f size)
+{
+    m_size = {std::max(size.x, 1.f), std::max(size.y, 1.f)};
+    // An edge may have moved out from under a resting pile.
+    wakeAll();
+}
+
+AABB world::getBounds(uint32_t index) const
+{
+    const AABB& local = m_localBounds[index];
+    return {m_positions[index] + local.min, m_positions[index] + local.max};
+}
+
+AABB world::getSweptBounds(uint32_t index) const
+{
+    const AABB& local = m_localBounds[index];
+    vector2f low = {std::min(m_positions[index].x, m_previousPositions[index].x),
+                    std::min(m_positions[index].y, m_previousPositions[index].y)};
+    vector2f high = {std::max(m_positions[index].x, m_previousPositions[index].x),
+                     std::max(m_positions[index].y, m_previousPositions[index].y)};
+    return {low + local.min, high + local.max};
+}
+
+vector2f world::getInterpolatedPosition(uint32_t index, float alpha) const
+{
+    return m_previousPositions[index] + (m_positions[index] - m_previousPositions[index]) * alpha;
+}
+
+void world::setMass(uint32_t index, float mass)
+{
+    m_masses[index] = mass;
+    m_invMasses[index] = 1 / mass;
+    wake(index);
+    ++m_revision;
+}
+
+const polygon& world::getPolygon(uint32_t index) const { return m_polygons[m_shapes[index]]; }
+
+bool world::isAsleep(uint32_t index) const { return m_asleep[index] != 0; }
+
+void world::sleep(uint32_t index)
+{
+    m_asleep[index] = 1;
+    m_velocities[index] = {0.f, 0.f};
+    m_previousPositions[index] = m_positions[index];
+}
+
+void world::wake(uint32_t index)
+{
+    m_asleep[index] = 0;
+    m_sleepTimers[index] = 0.f;
+}
+
+void world::wakeAll()
+{
+    std::fill(m_asleep.begin(), m_asleep.end(), 0);
+    std::fill(m_sleepTimers.begin(), m_sleepTimers.end(), 0.f);
+}
+
+std::vector<vector2f>& world::getPositions() { return m_positions; }
+std::vector<vector2f>& world::getVelocities() { return m_velocities; }
+std::vector<bodyInfo>& world::getInfo() { return m_info; }
+std::vector<float>& world::getSleepTimers() { return m_sleepTimers; }
+
+const std::vector<vector2f>& world::getPositions() const { return m_positions; }
+const std::vector<vector2f>& world::getPreviousPositions() const { return m_previousPositions; }
+const std::vector<vector2f>& world::getVelocities() const { return m_velocities; }
+const std::vector<float>& world::getMasses() const { return m_masses; }
+const std::vector<float>& world::getInvMasses() const { return m_invMasses; }
+const std::vector<vector2f>& world::getExtents() const { return m_extents; }
+const std::vector<AABB>& world::getLocalBounds() const { return m_localBounds; }
+const std::vector<objectType>& world::getTypes() const { return m_types; }
+const std::vector<bodyInfo>& world::getInfo() const { return m_info; }
+const std::vector<uint8_t>& world::getAsleep() const { return m_asleep; }
+
+AABB world::localBounds(objectType type, vector2f extents)
+{
+    switch(type)
+    {
+        case objectType::Circle:
+            return {{-extents.x, -extents.x}, {extents.x, extents.x}};
+        case objectType::Triangle:
+        {
+            // The base sits height / 3 above the centroid and the apex 2 * height / 3 below it.
+            float height = extents.x * std::sqrt(3.f) / 2.0f;
+            return {{-extents.x / 2.0f, -height / 3}, {extents.x / 2.0f, 2 * height / 3}};
+        }
+        case objectType::Square:
+        case objectType::Rectangle:
+        case objectType::Convex:
+        default:
+            // Convex bodies replace this with the bounds of their polygon.
+            return {{-extents.x / 2.0f, -extents.y / 2.0f}, {extents.x / 2.0f, extents.y / 2.0f}};
+    }
+}
+
+} // namespace kq